@@ -74,6 +74,7 @@ public:
       available_size = chunk_capacity - (ADDR)next_address 
                        + (ADDR)first_chunk;
       free_list = 0;
+      spare_chunks = 0;
    }
    
    ~MiamiAllocator()
@@ -85,6 +86,33 @@ public:
          first_chunk = (ADDR*)first_chunk[0];
          free(tmp_p);
       }
+      while(spare_chunks != NULL)
+      {
+         tmp_p = spare_chunks;
+         spare_chunks = (ADDR*)spare_chunks[0];
+         free(tmp_p);
+      }
+   }
+   
+   // releases all elements at once; the chunks are kept and handed out
+   // again by new_elem instead of allocating new ones
+   void clear()
+   {
+      ADDR* rest = (ADDR*)first_chunk[0];
+      if (rest)
+      {
+         ADDR* last = rest;
+         while (last[0])
+            last = (ADDR*)last[0];
+         last[0] = (ADDR)spare_chunks;
+         spare_chunks = rest;
+      }
+      first_chunk[0] = 0;
+      next_address = (ADDR*)((((ADDR)first_chunk + sizeof(ADDR) 
+                      + alignment - 1) / alignment) * alignment);
+      available_size = chunk_capacity - (ADDR)next_address 
+                       + (ADDR)first_chunk;
+      free_list = 0;
    }
    
    ElemType* new_elem()  //ElemType* p = NULL)
@@ -100,7 +128,12 @@ public:
          // this chunk is full; allocate another one
          {
             ADDR *temp = first_chunk;
-            first_chunk = (ADDR*)memalign(sizeof(ADDR), chunk_capacity);
+            if (spare_chunks)
+            {
+               first_chunk = spare_chunks;
+               spare_chunks = (ADDR*)spare_chunks[0];
+            } else
+               first_chunk = (ADDR*)memalign(sizeof(ADDR), chunk_capacity);
 
 #ifdef DEBUG_ALLOCATOR
             printf ("MiamiAllocator::new_elem, allocated new chunk\n");
@@ -144,6 +177,7 @@ private:
    ADDR* free_list;
    ADDR* next_address;
    ADDR* first_chunk;
+   ADDR* spare_chunks;  // chunks released by clear, not yet reused
 };
 
 } /* namespace MIAMIU */
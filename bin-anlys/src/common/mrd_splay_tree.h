@@ -618,6 +618,17 @@ public:
       return (distance);
    }
 
+   /*
+    * clear = removes all nodes; the node memory is kept by the allocator
+    *        for the nodes inserted next
+    */
+   void clear()
+   {
+      splay_allocator->clear();
+      tree_size = 0;
+      lastN = rootN = NULL;
+   }
+
 #if 1
    // We do not keep values in the tree, so it does not quite make sense to 
    // print it; We can try though for debugging if the program does not work
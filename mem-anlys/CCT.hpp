@@ -0,0 +1,220 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef CCT_H
+#define CCT_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+//***************************************************************************
+#include "FPTable.hpp"
+#include "Report.hpp"
+#include "Trace.hpp"
+#include "TraceStore.hpp"
+#include "metrics.hpp"
+using namespace std;
+
+#define CCT_ROOT 0
+#define CCT_NO_FRAME 0xffffffff
+
+// Calling-context tree of the sample call paths (.callpath file).
+// Frame names are interned; a node is (parent, frame) and keeps the samples
+// whose call path ends at it. Node ids are assigned on creation, so a parent
+// always has a smaller id than its children.
+class CCT {
+  public:
+    struct Node {
+      uint32_t parent;
+      uint32_t frame;            // interned frame name, CCT_NO_FRAME at the root
+      uint32_t depth;
+      vector <uint32_t> samples; // samples whose call path ends here
+    };
+
+    vector <Node> nodes;   // node CCT_ROOT is the root
+    vector <string> frames;
+
+    CCT(){
+      Node root;
+      root.parent = CCT_ROOT;
+      root.frame = CCT_NO_FRAME;
+      root.depth = 0;
+      nodes.push_back(root);
+    }
+
+    uint32_t internFrame(const string &name){
+      unordered_map <string, uint32_t>::iterator it = frameIDs.find(name);
+      if (it != frameIDs.end()){
+        return it->second;
+      }
+      frames.push_back(name);
+      frameIDs.insert({name, frames.size() - 1});
+      return frames.size() - 1;
+    }
+
+    uint32_t child(uint32_t parent, uint32_t frame){
+      uint64_t key = ((uint64_t)parent << 32) | frame;
+      unordered_map <uint64_t, uint32_t>::iterator it = children.find(key);
+      if (it != children.end()){
+        return it->second;
+      }
+      Node n;
+      n.parent = parent;
+      n.frame = frame;
+      n.depth = nodes[parent].depth + 1;
+      nodes.push_back(n);
+      children.insert({key, nodes.size() - 1});
+      return nodes.size() - 1;
+    }
+
+    // Adds the call path of a sample, frames ordered callee first
+    uint32_t insertPath(uint32_t sampleID, vector <uint32_t> &calleeFirst){
+      uint32_t node = CCT_ROOT;
+      for (auto it = calleeFirst.rbegin(); it != calleeFirst.rend(); it++){
+        node = child(node, *it);
+      }
+      nodes[node].samples.push_back(sampleID);
+      sampleNodes[sampleID] = node;
+      return node;
+    }
+
+    // Reads a .callpath file in one pass. Lines are
+    //   CG-LBR :*: <frame> :*: <sample id>
+    // and the lines of a sample are consecutive, innermost frame first.
+    void read(istream &in){
+      const string delim = " :*: ";
+      vector <uint32_t> path;
+      long lastID = -1;
+      string line;
+      while (getline(in, line)){
+        size_t p1 = line.find(delim);
+        size_t p2 = (p1 == string::npos) ? p1 : line.find(delim, p1 + delim.length());
+        assert(p2 != string::npos);
+        long sampleID = strtol(line.c_str() + p2 + delim.length(), NULL, 10);
+        if (sampleID != lastID && !path.empty()){
+          insertPath(lastID, path);
+          path.clear();
+        }
+        lastID = sampleID;
+        path.push_back(internFrame(line.substr(p1 + delim.length(), p2 - p1 - delim.length())));
+      }
+      if (!path.empty()){
+        insertPath(lastID, path);
+      }
+    }
+
+    // Node of a .callpath sample id; samples without a call path belong to
+    // the root
+    uint32_t nodeOf(uint32_t sampleID){
+      unordered_map <uint32_t, uint32_t>::iterator it = sampleNodes.find(sampleID);
+      return (it == sampleNodes.end()) ? CCT_ROOT : it->second;
+    }
+
+    string frameName(uint32_t node){
+      return (nodes[node].frame == CCT_NO_FRAME) ? "<root>" : frames[nodes[node].frame];
+    }
+
+    size_t size(){ return nodes.size();}
+    size_t getNumSamples(){ return sampleNodes.size();}
+
+  private:
+    unordered_map <string, uint32_t> frameIDs;
+    unordered_map <uint64_t, uint32_t> children;    // (parent, frame) -> node
+    unordered_map <uint32_t, uint32_t> sampleNodes; // sample id -> node
+};
+
+// Footprint and load-class metrics of every calling context. Exclusive
+// metrics count the accesses of the samples ending at a node, inclusive
+// ones those of its whole subtree. Per-class footprints split an address
+// accessed by several classes by access frequency, as for functions.
+class CCTMetrics {
+  public:
+    struct Row {
+      unsigned long accesses;
+      unsigned long exclFP;
+      unsigned long inclAccesses;
+      unsigned long inclFP;
+      double classFP[FPT_NCLASS]; // inclusive
+    };
+    vector <Row> rows; // by CCT node
+
+    // sampleCCT: CCT node of each trace sample (TraceStore sampleID)
+    void analyze(CCT *cct, vector <uint32_t> &sampleCCT, Trace *trace){
+      TraceStore *store = trace->store;
+      vector <FPTable> tables(cct->size());
+      rows.assign(cct->size(), Row());
+      for (auto it = trace->trace.begin(); it != trace->trace.end(); it++){
+        uint32_t sample = store->sampleID[*it];
+        uint32_t node = (sample < sampleCCT.size()) ? sampleCCT[sample] : CCT_ROOT;
+        tables[node].add(store->addr[*it], store->type[*it]);
+        rows[node].accesses++;
+      }
+      for (size_t n = 0; n < rows.size(); n++){
+        rows[n].exclFP = tables[n].size();
+        rows[n].inclAccesses += rows[n].accesses;
+      }
+      // children have larger ids: fold each subtree into its parent
+      for (size_t n = rows.size(); n-- > 0;){
+        Row &r = rows[n];
+        r.inclFP = tables[n].size();
+        for (int c = 0; c < FPT_NCLASS; c++){
+          r.classFP[c] = 0;
+        }
+        for (FPTable::iterator fp_it = tables[n].begin(); fp_it != tables[n].end(); fp_it++){
+          double total = 0;
+          for (int c = 0; c < FPT_NCLASS; c++){
+            total += fp_it->count[c];
+          }
+          for (int c = 0; c < FPT_NCLASS; c++){
+            r.classFP[c] += fp_it->count[c] / total;
+          }
+        }
+        if (n != CCT_ROOT){
+          uint32_t parent = cct->nodes[n].parent;
+          tables[parent].merge(tables[n]);
+          rows[parent].inclAccesses += r.inclAccesses;
+        }
+        tables[n].clear();
+      }
+    }
+
+    // Report table: one row per calling context in node order; inclusive
+    // unless Excl
+    ReportTable table(string name, CCT *cct){
+      ReportTable t(name);
+      t.column("Node", REPORT_INT).column("Parent", REPORT_INT).column("Depth", REPORT_INT)
+       .column("Samples", REPORT_INT).column("Accesses", REPORT_INT).column("Excl_Acc", REPORT_INT)
+       .column("FP", REPORT_INT).column("Excl_FP", REPORT_INT).column("Strided", REPORT_DOUBLE)
+       .column("Indirect", REPORT_DOUBLE).column("Constant", REPORT_DOUBLE).column("Unknown", REPORT_DOUBLE)
+       .column("Name", REPORT_STRING);
+      for (size_t n = 0; n < rows.size(); n++){
+        Row &r = rows[n];
+        t.row().put(n).put((int64_t)cct->nodes[n].parent).put((int64_t)cct->nodes[n].depth)
+         .put(cct->nodes[n].samples.size()).put(r.inclAccesses).put(r.accesses)
+         .put(r.inclFP).put(r.exclFP)
+         .put(r.classFP[FPTable::classOf(STRIDED)]).put(r.classFP[FPTable::classOf(INDIRECT)])
+         .put(r.classFP[FPTable::classOf(CONSTANT)]).put(r.classFP[FPTable::classOf(UNKNOWN)])
+         .put(cct->frameName(n));
+      }
+      return t;
+    }
+};
+
+#endif
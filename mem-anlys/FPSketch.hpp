@@ -0,0 +1,191 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef FPSKETCH_H
+#define FPSKETCH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "metrics.hpp"
+using namespace std;
+
+// Mergeable distinct-count sketch of a footprint (HyperLogLog).
+// Counts distinct addresses in total and per load class (strided,
+// indirect, constant, unknown). Small sets are kept sparse as a sorted list
+// of address hashes and are exact; once the list outgrows the dense size
+// it is converted to 2^precision registers per class. The relative
+// standard error of the dense estimate is 1.04/sqrt(2^precision).
+class FPSketch {
+  public:
+    enum { SK_TOTAL = 0, SK_STRIDED, SK_INDIRECT, SK_CONSTANT, SK_UNKNOWN, SK_NCLASS };
+
+    int precision;
+    bool dense;
+    vector <pair<uint64_t, uint8_t>> sparse;   // <hash, class bits>, sorted by hash
+    vector <uint8_t> regs;                    // SK_NCLASS x 2^precision registers
+
+    FPSketch(int _precision){
+      precision = _precision;
+      dense = false;
+    }
+
+    // Smallest precision with standard error <= err
+    static int precisionFor(double err){
+      int p = (int)ceil(log2((1.04 / err) * (1.04 / err)));
+      return max(4, min(p, 18));
+    }
+
+    static double stdError(int p){ return 1.04 / sqrt((double)(1UL << p));}
+
+    static int classOf(enum Metrics type){
+      switch (type){
+        case STRIDED:
+          return SK_STRIDED;
+        case INDIRECT:
+          return SK_INDIRECT;
+        case CONSTANT:
+          return SK_CONSTANT;
+        default:
+          return SK_UNKNOWN;
+      }
+    }
+
+    void add(unsigned long addr, enum Metrics type){
+      uint64_t h = hash(addr);
+      uint8_t bits = (1 << SK_TOTAL) | (1 << classOf(type));
+      if (dense){
+        addDense(h, bits);
+        return;
+      }
+      auto it = lower_bound(sparse.begin(), sparse.end(), make_pair(h, (uint8_t)0));
+      if (it != sparse.end() && it->first == h){
+        it->second |= bits;
+      } else {
+        sparse.insert(it, {h, bits});
+        if (sparse.size() > sparseLimit()){
+          toDense();
+        }
+      }
+    }
+
+    // Sketch state for the incremental state (Archive: CacheFile)
+    template <class Archive>
+    void serialize(Archive &ar){
+      ar.item(precision);
+      ar.item(dense);
+      ar.item(sparse);
+      ar.item(regs);
+    }
+
+    void merge(const FPSketch &other){
+      if (other.dense){
+        if (!dense){
+          toDense();
+        }
+        for (size_t i = 0; i < regs.size(); i++){
+          regs[i] = max(regs[i], other.regs[i]);
+        }
+      } else if (dense){
+        for (auto it = other.sparse.begin(); it != other.sparse.end(); it++){
+          addDense(it->first, it->second);
+        }
+      } else {
+        vector <pair<uint64_t, uint8_t>> merged;
+        merged.reserve(sparse.size() + other.sparse.size());
+        auto a = sparse.begin();
+        auto b = other.sparse.begin();
+        while (a != sparse.end() || b != other.sparse.end()){
+          if (b == other.sparse.end() || (a != sparse.end() && a->first < b->first)){
+            merged.push_back(*a++);
+          } else if (a == sparse.end() || b->first < a->first){
+            merged.push_back(*b++);
+          } else {
+            merged.push_back({a->first, (uint8_t)(a->second | b->second)});
+            a++;
+            b++;
+          }
+        }
+        sparse.swap(merged);
+        if (sparse.size() > sparseLimit()){
+          toDense();
+        }
+      }
+    }
+
+    // Distinct addresses of a class (SK_TOTAL for the footprint)
+    double estimate(int cls = SK_TOTAL){
+      if (!dense){
+        unsigned long n = 0;
+        for (auto it = sparse.begin(); it != sparse.end(); it++){
+          if (it->second & (1 << cls)){
+            n++;
+          }
+        }
+        return n;
+      }
+      size_t m = 1UL << precision;
+      const uint8_t *r = &regs[cls * m];
+      double sum = 0;
+      unsigned long zeros = 0;
+      for (size_t i = 0; i < m; i++){
+        sum += ldexp(1.0, -r[i]);
+        if (r[i] == 0){
+          zeros++;
+        }
+      }
+      double alpha = 0.7213 / (1.0 + 1.079 / m);
+      double est = alpha * m * m / sum;
+      if (est <= 2.5 * m && zeros > 0){
+        est = m * log((double)m / zeros); // linear counting for small sets
+      }
+      return est;
+    }
+
+  private:
+    static uint64_t hash(unsigned long x){
+      uint64_t z = x + 0x9e3779b97f4a7c15ULL;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    size_t sparseLimit(){ return ((size_t)1 << precision) * SK_NCLASS / 16;}
+
+    void addDense(uint64_t h, uint8_t bits){
+      size_t m = 1UL << precision;
+      size_t idx = h >> (64 - precision);
+      uint64_t w = (h << precision) | ((uint64_t)1 << (precision - 1));
+      uint8_t rank = __builtin_clzll(w) + 1;
+      for (int c = 0; c < SK_NCLASS; c++){
+        if ((bits & (1 << c)) && regs[c * m + idx] < rank){
+          regs[c * m + idx] = rank;
+        }
+      }
+    }
+
+    void toDense(){
+      regs.assign(SK_NCLASS * ((size_t)1 << precision), 0);
+      dense = true;
+      for (auto it = sparse.begin(); it != sparse.end(); it++){
+        addDense(it->first, it->second);
+      }
+      vector <pair<uint64_t, uint8_t>>().swap(sparse);
+    }
+};
+
+#endif
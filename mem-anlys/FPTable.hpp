@@ -0,0 +1,209 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef FPTABLE_H
+#define FPTABLE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "metrics.hpp"
+using namespace std;
+
+// Footprint table: address -> access count per load class.
+// Flat open-addressing hash table (linear probing, load factor <= 1/2)
+// replacing map <address, map <type, count>>: one probe sequence and no
+// node allocation per access. Entries keep a fixed counter array indexed
+// by load class; a class is present for an address when its counter is
+// non-zero. Load types other than the classes below are counted as
+// UNKNOWN. The address ~0UL is reserved as the empty key.
+#define FPT_NCLASS 5
+
+class FPTable {
+  public:
+    struct Entry {
+      unsigned long addr;
+      uint32_t count[FPT_NCLASS];
+    };
+
+    // Class order follows enum Metrics order so per-class loops visit types
+    // in the order of the former map
+    static int classOf(enum Metrics type){
+      switch (type){
+        case CONSTANT:
+          return 1;
+        case STRIDED:
+          return 2;
+        case INDIRECT:
+          return 3;
+        case STORE:
+          return 4;
+        default:
+          return 0; // UNKNOWN
+      }
+    }
+    static enum Metrics typeOf(int cls){
+      static const enum Metrics types[FPT_NCLASS] = {UNKNOWN, CONSTANT, STRIDED, INDIRECT, STORE};
+      return types[cls];
+    }
+
+    // Number of classes with a non-zero count
+    static int numTypes(const Entry &e){
+      int n = 0;
+      for (int c = 0; c < FPT_NCLASS; c++){
+        if (e.count[c]){
+          n++;
+        }
+      }
+      return n;
+    }
+
+    class iterator {
+      public:
+        iterator(Entry *_p, Entry *_end){ p = _p; end = _end; skip();}
+        Entry & operator*(){ return *p;}
+        Entry * operator->(){ return p;}
+        iterator & operator++(){ p++; skip(); return *this;}
+        iterator operator++(int){ iterator t = *this; ++(*this); return t;}
+        bool operator==(const iterator &o) const { return p == o.p;}
+        bool operator!=(const iterator &o) const { return p != o.p;}
+      private:
+        Entry *p, *end;
+        void skip(){ while (p != end && p->addr == EMPTY) p++;}
+    };
+
+    FPTable(){ used = 0; mask = 0; shift = 64;}
+
+    iterator begin(){ return iterator(slots.data(), slots.data() + slots.size());}
+    iterator end(){ return iterator(slots.data() + slots.size(), slots.data() + slots.size());}
+
+    size_t size() const { return used;}
+    bool empty() const { return used == 0;}
+
+    void reserve(size_t n){
+      size_t cap = 16;
+      while (cap < 2 * n){
+        cap <<= 1;
+      }
+      if (cap > slots.size()){
+        rehash(cap);
+      }
+    }
+
+    // Counters of addr, inserting a zeroed entry if it is not present
+    Entry & get(unsigned long addr){
+      if (2 * (used + 1) > slots.size()){
+        rehash(slots.empty() ? 16 : 2 * slots.size());
+      }
+      size_t i = hash(addr);
+      while (slots[i].addr != addr){
+        if (slots[i].addr == EMPTY){
+          slots[i].addr = addr;
+          used++;
+          break;
+        }
+        i = (i + 1) & mask;
+      }
+      return slots[i];
+    }
+
+    Entry * find(unsigned long addr){
+      if (used == 0){
+        return NULL;
+      }
+      size_t i = hash(addr);
+      while (slots[i].addr != EMPTY){
+        if (slots[i].addr == addr){
+          return &slots[i];
+        }
+        i = (i + 1) & mask;
+      }
+      return NULL;
+    }
+
+    void add(unsigned long addr, enum Metrics type, uint32_t n = 1){
+      get(addr).count[classOf(type)] += n;
+    }
+
+    // Adds the counters of every address of o
+    void merge(FPTable &o){
+      reserve(used + o.used);
+      for (iterator it = o.begin(); it != o.end(); it++){
+        Entry &e = get(it->addr);
+        for (int c = 0; c < FPT_NCLASS; c++){
+          e.count[c] += it->count[c];
+        }
+      }
+    }
+
+    void clear(){
+      vector <Entry>().swap(slots);
+      used = 0;
+      mask = 0;
+      shift = 64;
+    }
+
+    // Raw slots, so a table read back iterates in the same order
+    // (incremental state; Archive: CacheFile)
+    template <class Archive>
+    void serialize(Archive &ar){
+      ar.item(slots);
+      ar.item(used);
+      ar.item(mask);
+      ar.item(shift);
+    }
+
+    void swap(FPTable &o){
+      slots.swap(o.slots);
+      std::swap(used, o.used);
+      std::swap(mask, o.mask);
+      std::swap(shift, o.shift);
+    }
+
+  private:
+    static const unsigned long EMPTY = ~0UL;
+    vector <Entry> slots;
+    size_t used;
+    size_t mask;
+    int shift;
+
+    // Fibonacci hashing: top bits of the product
+    size_t hash(unsigned long addr){
+      return (addr * 0x9e3779b97f4a7c15ULL) >> shift;
+    }
+
+    void rehash(size_t cap){
+      vector <Entry> old;
+      old.swap(slots);
+      Entry e;
+      memset(&e, 0, sizeof(e));
+      e.addr = EMPTY;
+      slots.assign(cap, e);
+      mask = cap - 1;
+      shift = 64 - __builtin_ctzll(cap);
+      for (auto it = old.begin(); it != old.end(); it++){
+        if (it->addr != EMPTY){
+          size_t i = hash(it->addr);
+          while (slots[i].addr != EMPTY){
+            i = (i + 1) & mask;
+          }
+          slots[i] = *it;
+        }
+      }
+    }
+};
+
+#endif
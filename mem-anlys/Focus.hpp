@@ -0,0 +1,228 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef FOCUS_H
+#define FOCUS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+//***************************************************************************
+#include "FuncIndex.hpp"
+#include "Trace.hpp"
+#include "TraceStore.hpp"
+using namespace std;
+
+// Address ranges -> region ids.
+// Implicit augmented interval tree: the ranges are sorted by start and the
+// sorted array is read as a complete binary tree (node i at level k has
+// children i -/+ 2^(k-1)); every node keeps the maximum end of its subtree
+// so a lookup only descends into subtrees that can contain the address.
+// Ranges are inclusive [lo, hi] and may overlap; a lookup returns all
+// ranges containing the address.
+class RegionIndex {
+  public:
+    RegionIndex(){ maxLevel = -1;}
+
+    // Adds [lo, hi]; call build before find
+    void add(unsigned long lo, unsigned long hi, int id){
+      Node n;
+      n.lo = lo;
+      n.hi = hi;
+      n.max = hi;
+      n.id = id;
+      nodes.push_back(n);
+    }
+
+    void build(){
+      sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b){ return a.lo < b.lo;});
+      size_t n = nodes.size();
+      maxLevel = -1;
+      if (n == 0){
+        return;
+      }
+      size_t last_i = 0;
+      unsigned long last = 0;
+      for (size_t i = 0; i < n; i += 2){ // leaves
+        last_i = i;
+        last = nodes[i].max = nodes[i].hi;
+      }
+      int k;
+      for (k = 1; (1UL << k) <= n; k++){
+        size_t x = 1UL << (k - 1), i0 = (x << 1) - 1, step = x << 2;
+        for (size_t i = i0; i < n; i += step){
+          unsigned long el = nodes[i - x].max;
+          unsigned long er = (i + x < n) ? nodes[i + x].max : last;
+          nodes[i].max = max(nodes[i].hi, max(el, er));
+        }
+        last_i = ((last_i >> k) & 1) ? last_i - x : last_i + x;
+        if (last_i < n && nodes[last_i].max > last){
+          last = nodes[last_i].max;
+        }
+      }
+      maxLevel = k - 1;
+    }
+
+    // Region ids of every range containing addr, appended to ids
+    void find(unsigned long addr, vector <int> &ids){
+      if (maxLevel < 0){
+        return;
+      }
+      size_t n = nodes.size();
+      struct Frame { int k; size_t x; bool leftDone; };
+      Frame stack[64];
+      int t = 0;
+      stack[t++] = {maxLevel, (1UL << maxLevel) - 1, false};
+      while (t){
+        Frame z = stack[--t];
+        if (z.k <= 3){ // small subtree: scan it
+          size_t i0 = z.x >> z.k << z.k, i1 = i0 + (1UL << (z.k + 1)) - 1;
+          if (i1 > n){
+            i1 = n;
+          }
+          for (size_t i = i0; i < i1 && nodes[i].lo <= addr; i++){
+            if (addr <= nodes[i].hi){
+              ids.push_back(nodes[i].id);
+            }
+          }
+        } else if (!z.leftDone){
+          size_t y = z.x - (1UL << (z.k - 1));
+          stack[t++] = {z.k, z.x, true};
+          if (y >= n || nodes[y].max >= addr){
+            stack[t++] = {z.k - 1, y, false};
+          }
+        } else if (z.x < n && nodes[z.x].lo <= addr){
+          if (addr <= nodes[z.x].hi){
+            ids.push_back(nodes[z.x].id);
+          }
+          stack[t++] = {z.k - 1, z.x + (1UL << (z.k - 1)), false};
+        }
+      }
+    }
+
+    size_t size(){ return nodes.size();}
+
+  private:
+    struct Node {
+      unsigned long lo, hi; // [lo, hi]
+      unsigned long max;    // maximum hi of the subtree
+      int id;
+    };
+    vector <Node> nodes;
+    int maxLevel;
+};
+
+// A region or function set of the -F spec and its accesses
+struct FocusSet {
+  enum Kind { REGION, FUNCTION };
+  Kind kind;
+  string name;            // region name or function name pattern
+  unsigned long lo, hi;   // region [lo, hi]
+  Trace *trace;           // accesses of the set in trace order
+};
+
+// Focus spec (-F): many regions and function sets analyzed in one pass.
+// One entry per line, '#' starts a comment:
+//   region <name> <lo> <hi>    addresses in [lo, hi] (hex), as -rl/-rh
+//   function <pattern>         functions whose name contains pattern, as -f
+class FocusSpec {
+  public:
+    vector <FocusSet> sets;
+
+    FocusSpec(TraceStore *_store){ store = _store;}
+
+    bool read(string fileName){
+      ifstream in(fileName);
+      if (!in.is_open()){
+        return false;
+      }
+      string line;
+      int lineno = 0;
+      while (getline(in, line)){
+        lineno++;
+        size_t pos = line.find('#');
+        if (pos != string::npos){
+          line.erase(pos);
+        }
+        istringstream ss(line);
+        string kind;
+        if (!(ss >> kind)){
+          continue;
+        }
+        FocusSet s;
+        s.lo = 0;
+        s.hi = 0;
+        s.trace = new Trace(store);
+        string lo, hi;
+        if (kind == "region" && (ss >> s.name >> lo >> hi)){
+          s.kind = FocusSet::REGION;
+          s.lo = strtoul(lo.c_str(), NULL, 16);
+          s.hi = strtoul(hi.c_str(), NULL, 16);
+          regions.add(s.lo, s.hi, sets.size());
+        } else if (kind == "function" && (ss >> ws) && getline(ss, s.name) && !s.name.empty()){
+          s.kind = FocusSet::FUNCTION;
+          functionSets.push_back(sets.size());
+        } else {
+          cerr << "Error: " << fileName << ":" << lineno << ": bad focus entry: " << line << endl;
+          delete s.trace;
+          continue;
+        }
+        sets.push_back(s);
+      }
+      regions.build();
+      return true;
+    }
+
+    // Matches the function sets against the functions of funcIndex
+    void bindFunctions(FuncIndex &funcIndex){
+      funcSets.assign(funcIndex.size(), vector<int>());
+      for (size_t f = 0; f < funcIndex.size(); f++){
+        const string &name = funcIndex.getFunction(f)->name;
+        for (auto it = functionSets.begin(); it != functionSets.end(); it++){
+          if (name.find(sets[*it].name) != string::npos){
+            funcSets[f].push_back(*it);
+          }
+        }
+      }
+    }
+
+    // Adds trace entry a (attributed to FuncIndex function funcIdx, -1 if
+    // none) to every set containing it
+    void addAccess(uint32_t a, int funcIdx){
+      hits.clear();
+      regions.find(store->addr[a], hits);
+      if (funcIdx >= 0 && (size_t)funcIdx < funcSets.size()){
+        hits.insert(hits.end(), funcSets[funcIdx].begin(), funcSets[funcIdx].end());
+      }
+      for (auto it = hits.begin(); it != hits.end(); it++){
+        sets[*it].trace->addAccess(a);
+      }
+    }
+
+  private:
+    TraceStore *store;
+    RegionIndex regions;
+    vector <int> functionSets;       // ids of the function sets
+    vector <vector <int>> funcSets;  // FuncIndex function -> function sets
+    vector <int> hits;
+};
+
+#endif
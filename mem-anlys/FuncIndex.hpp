@@ -0,0 +1,176 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef FUNCINDEX_H
+#define FUNCINDEX_H
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+//***************************************************************************
+#include "Function.hpp"
+#include "TraceBin.hpp"
+#include "TraceStore.hpp"
+using namespace std;
+
+// <load module index, start IP> -> function
+typedef map <pair<uint16_t, unsigned long>, memgaze::Function *> FuncMap;
+
+// IP -> function attribution.
+// Every hpcstruct <LM> is a load module with its own function bounds. The
+// <P entries of a module are flattened into a sorted table of contiguous
+// intervals [startIP, next startIP); the last function ends at the end of
+// the module's code. A load is looked up in the module named by its trace
+// DSO id; traces without DSO ids use the first module whose code covers
+// the IP.
+// Lookups are memoized per (DSO, IP) since the same load IPs repeat
+// throughout a trace.
+class FuncIndex {
+  public:
+    FuncIndex(TraceStore *_store){
+      store = _store;
+      hasLast = false;
+      lastKey = 0;
+      lastIdx = -1;
+    }
+
+    // Adds a load module (hpcstruct <LM n="...">), returns its index
+    uint16_t addModule(string name){
+      Module m;
+      m.name = name;
+      m.first = 0;
+      m.last = 0;
+      m.lo = ~0UL;
+      m.hi = 0;
+      modules.push_back(m);
+      return modules.size() - 1;
+    }
+
+    // Extends the code range of module m to cover [lo, hi)
+    void extendModule(uint16_t m, unsigned long lo, unsigned long hi){
+      modules[m].lo = min(modules[m].lo, lo);
+      modules[m].hi = max(modules[m].hi, hi);
+    }
+
+    // Builds the interval tables and sets the endIP of every function
+    void build(FuncMap &funcMAP){
+      starts.clear();
+      funcs.clear();
+      ipMemo.clear();
+      hasLast = false;
+      lmModule.assign(TRACEBIN_NO_DSO + 1, LM_UNRESOLVED);
+      for (auto it = funcMAP.begin(); it != funcMAP.end(); it++){
+        uint16_t m = it->first.first;
+        if (funcs.empty() || it->first.first != prevModule){
+          modules[m].first = funcs.size();
+        } else {
+          funcs.back()->endIP = it->first.second - 1;
+        }
+        starts.push_back(it->first.second);
+        funcs.push_back(it->second);
+        modules[m].last = funcs.size();
+        extendModule(m, it->first.second, it->first.second + 1);
+        it->second->endIP = modules[m].hi - 1;
+        prevModule = m;
+      }
+    }
+
+    // Function index of (trace DSO id, ip), -1 if ip is not in any function
+    int find(uint16_t lm, unsigned long ip){
+      unsigned long key = ((unsigned long)lm << 48) ^ ip;
+      if (hasLast && key == lastKey){
+        return lastIdx;
+      }
+      int idx;
+      unordered_map <unsigned long, int>::iterator mit = ipMemo.find(key);
+      if (mit != ipMemo.end()){
+        idx = mit->second;
+      } else {
+        idx = -1;
+        int m = moduleOf(lm, ip);
+        if (m >= 0 && modules[m].first < modules[m].last && ip < modules[m].hi){
+          vector <unsigned long>::iterator sit = upper_bound(starts.begin() + modules[m].first,
+                                                             starts.begin() + modules[m].last, ip);
+          if (sit != starts.begin() + modules[m].first){
+            idx = sit - starts.begin() - 1;
+          }
+        }
+        ipMemo.insert({key, idx});
+      }
+      hasLast = true;
+      lastKey = key;
+      lastIdx = idx;
+      return idx;
+    }
+
+    memgaze::Function * getFunction(int idx){ return funcs[idx];}
+    size_t size(){ return funcs.size();}
+    size_t getNumModules(){ return modules.size();}
+
+  private:
+    struct Module {
+      string name;          // path of the load module
+      size_t first, last;   // intervals [first, last) of the module
+      unsigned long lo, hi; // code range [lo, hi)
+    };
+    static const int LM_UNRESOLVED = -2;
+
+    TraceStore *store;
+    vector <Module> modules;
+    vector <unsigned long> starts;         // function start IPs, sorted per module
+    vector <memgaze::Function *> funcs;    // function of each interval
+    vector <int> lmModule;                 // trace DSO id -> module, -1 if none
+    uint16_t prevModule;
+    unordered_map <unsigned long, int> ipMemo;
+    bool hasLast;                          // last lookup, consecutive loads share IPs
+    unsigned long lastKey;
+    int lastIdx;
+
+    static string baseName(const string &path){
+      size_t pos = path.find_last_of('/');
+      return (pos == string::npos) ? path : path.substr(pos + 1);
+    }
+
+    int moduleOf(uint16_t lm, unsigned long ip){
+      if (modules.size() == 1){
+        return 0; // a single module needs no DSO ids
+      }
+      if (lm != TRACEBIN_NO_DSO){
+        if (lmModule[lm] == LM_UNRESOLVED){
+          // trace DSO names are a path or a file name
+          string dso = store->getLoadModule(lm);
+          lmModule[lm] = -1;
+          for (size_t m = 0; m < modules.size(); m++){
+            if (modules[m].name == dso || baseName(modules[m].name) == baseName(dso)){
+              lmModule[lm] = m;
+              break;
+            }
+          }
+        }
+        return lmModule[lm];
+      }
+      for (size_t m = 0; m < modules.size(); m++){
+        if (modules[m].lo <= ip && ip < modules[m].hi){
+          return m;
+        }
+      }
+      return -1;
+    }
+};
+
+#endif
@@ -16,6 +16,7 @@
 //***************************************************************************
 #include <fstream>
 #include <regex>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <fcntl.h>
@@ -32,9 +33,7 @@
 #include <algorithm>
 //***************************************************************************
 #include "Function.hpp"
-#include "Address.hpp"
-#include "Instruction.hpp"
-#include "CPU.hpp"
+#include "Parallel.hpp"
 //***************************************************************************
 using namespace std;
 using namespace memgaze;
@@ -47,143 +46,131 @@ using namespace memgaze;
 //   totalLoads =  0;
 // }
 
-Function::Function  (std::string _name, uint16_t _load_module, unsigned long _s,  unsigned long _e, int _ncpus) { 
+Function::Function  (TraceStore *_store, std::string _name, uint16_t _load_module, unsigned long _s,  unsigned long _e) { 
   startIP = _s;
   endIP = _e;
   name = _name;
   totalLoads =  0;
-  ncpus = _ncpus;
-  cpuFP.reserve(ncpus);
-  cpuFPMap.reserve(ncpus);
+  prevLoads = 0;
+  ncpus = 0; // set by calcCPUFP from the CPUs of the trace
+  sharedFP = 0;
   load_module = _load_module;
-  for (int i=0; i<ncpus; i++) {
-    map <unsigned long, map <enum Metrics,int>> tmp;
-    cpuFPMap.push_back(tmp);
-    cpuFP.push_back(-1);
-  }
-  trace = new Trace();
+  trace = new Trace(_store);
 }
 
 
-Function::Function  (std::string _name, unsigned long _s,  unsigned long _e, int _ncpus) { 
+Function::Function  (TraceStore *_store, std::string _name, unsigned long _s,  unsigned long _e) { 
   startIP = _s;
   endIP = _e;
   name = _name;
   totalLoads =  0;
-  ncpus = _ncpus;
-  cpuFP.reserve(ncpus);
-  cpuFPMap.reserve(ncpus);
-  for (int i=0; i<ncpus; i++) {
-    map <unsigned long, map <enum Metrics,int>> tmp;
-    cpuFPMap.push_back(tmp);
-    cpuFP.push_back(-1);
-  }
-  trace = new Trace();
+  prevLoads = 0;
+  ncpus = 0; // set by calcCPUFP from the CPUs of the trace
+  sharedFP = 0;
+  trace = new Trace(_store);
 }
 
 int Function::getFP(){return fp;}
 
 void Function::calcFP(){
-  map <enum Metrics,int>typemap;
-  map <unsigned long, map <enum Metrics, int>>::iterator typeMapIt;
+  TraceStore *store = trace->store;
 //OZGURCLEANUP  for(auto it = timeVec.begin(); it != timeVec.end(); it++) {
   for(auto it = trace->trace.begin(); it != trace->trace.end(); it++) {
-    typeMapIt = this->fpMap.find((*it)->addr->addr);
-    if (typeMapIt != fpMap.end()){
-      map <enum Metrics, int>::iterator tit = typeMapIt->second.find((*it)->ip->type);
-      if (tit != typeMapIt->second.end()){
-        tit->second++;
-      } else {
-        typeMapIt->second.insert({(*it)->ip->type, 1});
-      }
-    } else {
-      typemap.insert({(*it)->ip->type,  1});
-      this->fpMap.insert({(*it)->addr->addr, typemap});
-      typemap.clear();
-    }
+    this->fpMap.add(store->addr[*it], store->type[*it]);
   }
   fp = this->fpMap.size();
 }
 
-void Function::calcCPUFP(){
-//   cout << "[NVDBG]: Begin CPU FP" << endl;
-//   cout << "[NVDBG]: cpuFPMap size " << cpuFPMap.size() << endl;
-//   cout << "[NVDBG]: timeVec size " << timeVec.size() << endl;
-  map <enum Metrics,int>typemap;
-  map <unsigned long, map <enum Metrics, int>>::iterator typeMapIt;
-//OZGURCLEANUP  for(auto it = timeVec.begin(); it != timeVec.end(); it++) {
+// Per-CPU footprints: the accesses are sharded by compact CPU index and
+// each shard's table is built on the thread pool. Like fpMap in calcFP,
+// tables seeded by earlier trace parts are extended.
+void Function::calcCPUFP(unsigned int nthreads){
+  TraceStore *store = trace->store;
+  this->ncpus = store->getNumCPUs();
+  vector <vector <uint32_t>> shards(ncpus);
   for(auto it = trace->trace.begin(); it != trace->trace.end(); it++) {
-    uint16_t cpuid = (*it)->cpu->cpu;
-    typeMapIt = (this->cpuFPMap[cpuid]).find((*it)->addr->addr);
-    // cout << "[NVDBG]: cpuid " << cpuid << " typeMapIt " << endl;
-
-    if (typeMapIt != cpuFPMap[cpuid].end()){
-      map <enum Metrics, int>::iterator tit = typeMapIt->second.find((*it)->ip->type);
-      if (tit != typeMapIt->second.end()){
-        tit->second++;
-      } else {
-        typeMapIt->second.insert({(*it)->ip->type, 1});
+    shards[store->cpuOf(*it)].push_back(*it);
+  }
+  this->cpuFPMap.resize(ncpus);
+  this->cpuFP.assign(ncpus, -1);
+  parallelFor(ncpus, nthreads, [&](size_t cpuid){
+    for (auto it = shards[cpuid].begin(); it != shards[cpuid].end(); it++){
+      this->cpuFPMap[cpuid].add(store->addr[*it], store->type[*it]);
+    }
+    this->cpuFP[cpuid] =  this->cpuFPMap[cpuid].size();
+  });
+
+  // Cross-CPU sharing: number of CPUs touching each address
+  unordered_map <unsigned long, int> addrCPUs;
+  for (int cpuid=0; cpuid<this->ncpus; cpuid++){
+    for (FPTable::iterator fp_it = cpuFPMap[cpuid].begin(); fp_it != cpuFPMap[cpuid].end(); fp_it++){
+      addrCPUs[fp_it->addr]++;
+    }
+  }
+  this->sharedFP = 0;
+  for (auto it = addrCPUs.begin(); it != addrCPUs.end(); it++){
+    if (it->second > 1){
+      this->sharedFP++;
+    }
+  }
+  this->cpuSharedFP.assign(ncpus, 0);
+  for (int cpuid=0; cpuid<this->ncpus; cpuid++){
+    for (FPTable::iterator fp_it = cpuFPMap[cpuid].begin(); fp_it != cpuFPMap[cpuid].end(); fp_it++){
+      if (addrCPUs[fp_it->addr] > 1){
+        this->cpuSharedFP[cpuid]++;
       }
-    } else {
-      typemap.insert({(*it)->ip->type,  1});
-      this->cpuFPMap[cpuid].insert({(*it)->addr->addr, typemap});
-      typemap.clear();
     }
   }
-//   cout << "[NVDBG]: cpuFPMap sucessfully constructed" << endl;
-  for (int cpuid=0; cpuid<this->ncpus; cpuid++)
-    this->cpuFP[cpuid] =  this->cpuFPMap[cpuid].size();
 }
 
-void Function::getdiagMap (map <enum Metrics,int> *typeMap, map <enum Metrics, double> *fpDiagMap) {
-  map <enum Metrics, int>::iterator tit = typeMap->begin();
+void Function::getdiagMap (FPTable::Entry *typeMap, map <enum Metrics, double> *fpDiagMap) {
   map <enum Metrics, double>::iterator did;
   double total = 0;
   double freq = 1.0; 
-  for (;tit != typeMap->end(); tit++){
-    total +=tit->second;
+  for (int c = 0; c < FPT_NCLASS; c++){
+    total +=typeMap->count[c];
   }
-  for (tit = typeMap->begin();  tit != typeMap->end(); tit++){
-    freq =  ( (double)tit->second / (double)total);
-    did =  fpDiagMap->find(tit->first);
+  for (int c = 0; c < FPT_NCLASS; c++){
+    if (typeMap->count[c] == 0){
+      continue;
+    }
+    enum Metrics type = FPTable::typeOf(c);
+    freq =  ( (double)typeMap->count[c] / (double)total);
+    did =  fpDiagMap->find(type);
     if (did !=  fpDiagMap->end()){
       did->second += freq;
     } else { 
-      fpDiagMap->insert({tit->first, freq});
+      fpDiagMap->insert({type, freq});
     }
   }
 }
 
-void  Function::getFPDiag(map <enum Metrics, double> *diagMap){ // this map holds fp per type
-  map <unsigned long, map <enum Metrics,int>>::iterator fp_it = this->fpMap.begin();
-  for (; fp_it != this->fpMap.end() ;  fp_it++){
-    if (fp_it->second.size() ==1){
-      map <enum Metrics, double >::iterator dmit =  diagMap->find(fp_it->second.begin()->first);
+// Adds the per-type footprint of fpTable to diagMap
+static void addFPDiag(FPTable &fpTable, map <enum Metrics, double> *diagMap, Function *f){
+  for (FPTable::iterator fp_it = fpTable.begin(); fp_it != fpTable.end() ;  fp_it++){
+    if (FPTable::numTypes(*fp_it) ==1){
+      int c = 0;
+      while (fp_it->count[c] == 0){
+        c++;
+      }
+      map <enum Metrics, double >::iterator dmit =  diagMap->find(FPTable::typeOf(c));
       if (dmit != diagMap->end()){
         dmit->second++;
       } else {
-        diagMap->insert({fp_it->second.begin()->first, 1.0});
+        diagMap->insert({FPTable::typeOf(c), 1.0});
       }
     } else { 
-      getdiagMap(&(fp_it->second), diagMap);    
+      f->getdiagMap(&(*fp_it), diagMap);    
     }
   } 
 }
 
+void  Function::getFPDiag(map <enum Metrics, double> *diagMap){ // this map holds fp per type
+  addFPDiag(this->fpMap, diagMap, this);
+}
+
 void Function::getCPUFPDiag(map <enum Metrics, double> *cpuDiagMap, uint16_t cpuid) {
-    map <unsigned long, map <enum Metrics,int>>::iterator fp_it = this->cpuFPMap[cpuid].begin();
-    for (; fp_it != this->cpuFPMap[cpuid].end() ;  fp_it++){
-        if (fp_it->second.size() ==1){
-        map <enum Metrics, double >::iterator dmit = (cpuDiagMap)->find(fp_it->second.begin()->first);
-        if (dmit != (cpuDiagMap)->end()){
-            dmit->second++;
-        } else {
-            (cpuDiagMap)->insert({fp_it->second.begin()->first, 1.0});
-        }
-        } else { 
-            getdiagMap(&(fp_it->second), (cpuDiagMap));    
-        }
-    }
+  addFPDiag(this->cpuFPMap[cpuid], cpuDiagMap, this);
 }
 
 
@@ -192,7 +179,7 @@ void Function::getCPUFPDiag(map <enum Metrics, double> *cpuDiagMap, uint16_t cpu
 //}
 
 Trace * Function::calculateFunctionFPRec(Function *root,  int level ){
-    Trace * childTimeVec = new Trace();
+    Trace * childTimeVec = new Trace(root->trace->store);
     std::vector<Trace * > tempVec;
     if (root == NULL){
       return childTimeVec;
@@ -206,79 +193,42 @@ Trace * Function::calculateFunctionFPRec(Function *root,  int level ){
       }
     }
     map <unsigned long, int> functionFPMap; // will hold every new access 
-    map <enum Metrics,int>typemap;
-    map <unsigned long, map <enum Metrics, int>>::iterator typeMapIt;
+    TraceStore *store = root->trace->store;
     if (tempVec.empty()){
       for(auto it = root->trace->trace.begin(); it != root->trace->trace.end(); it++) {
         root->totalLoads++;
-        map <unsigned long, int>::iterator fmapIter = functionFPMap.find((*it)->addr->addr);
+        map <unsigned long, int>::iterator fmapIter = functionFPMap.find(store->addr[*it]);
         if (fmapIter != functionFPMap.end()){
           fmapIter->second++;
         } else {
-          functionFPMap.insert({(*it)->addr->addr,1});
+          functionFPMap.insert({store->addr[*it],1});
           childTimeVec->addAccess(*it);
         } 
-        typeMapIt = root->fpMap.find((*it)->addr->addr);
-        if (typeMapIt != root->fpMap.end()){
-          map <enum Metrics, int>::iterator tit = typeMapIt->second.find((*it)->ip->type);
-          if (tit != typeMapIt->second.end()){
-            tit->second++;
-          } else {
-            typeMapIt->second.insert({(*it)->ip->type, 1});
-          }
-        } else {
-          typemap.insert({(*it)->ip->type,  1});
-          root->fpMap.insert({(*it)->addr->addr, typemap});
-          typemap.clear();
-        }
+        root->fpMap.add(store->addr[*it], store->type[*it]);
       }
     } else {
       for (auto tit = tempVec.begin(); tit  != tempVec.end(); tit++){
         for(auto it = (*tit)->trace.begin(); it != (*tit)->trace.end(); it++) {
-          map <unsigned long, int>::iterator fmapIter = functionFPMap.find((*it)->addr->addr);
+          map <unsigned long, int>::iterator fmapIter = functionFPMap.find(store->addr[*it]);
           if (fmapIter != functionFPMap.end()){
             fmapIter->second++;
           } else {
-            functionFPMap.insert({(*it)->addr->addr,1});
+            functionFPMap.insert({store->addr[*it],1});
             childTimeVec->addAccess(*it);
           }
-          typeMapIt = root->fpMap.find((*it)->addr->addr);
-          if (typeMapIt != root->fpMap.end()){
-            map <enum Metrics, int>::iterator tit = typeMapIt->second.find((*it)->ip->type);
-            if (tit != typeMapIt->second.end()){
-              tit->second++;
-            } else {
-              typeMapIt->second.insert({(*it)->ip->type, 1});
-            }
-          } else {
-            typemap.insert({(*it)->ip->type,  1});
-            root->fpMap.insert({(*it)->addr->addr, typemap});
-            typemap.clear();
-          }
+          root->fpMap.add(store->addr[*it], store->type[*it]);
         }
       }
       for(auto it = root->trace->trace.begin(); it != root->trace->trace.end(); it++) {
         root->totalLoads++;
-        map <unsigned long, int>::iterator fmapIter = functionFPMap.find((*it)->addr->addr);
+        map <unsigned long, int>::iterator fmapIter = functionFPMap.find(store->addr[*it]);
         if (fmapIter != functionFPMap.end()){
-          functionFPMap.insert({(*it)->addr->addr,fmapIter->second +1});
+          functionFPMap.insert({store->addr[*it],fmapIter->second +1});
         } else {
-          functionFPMap.insert({(*it)->addr->addr,1});
+          functionFPMap.insert({store->addr[*it],1});
           childTimeVec->addAccess(*it);
         }
-        typeMapIt = root->fpMap.find((*it)->addr->addr);
-        if (typeMapIt != root->fpMap.end()){
-          map <enum Metrics, int>::iterator tit = typeMapIt->second.find((*it)->ip->type);
-          if (tit != typeMapIt->second.end()){
-            tit->second++;
-          } else {
-            typeMapIt->second.insert({(*it)->ip->type, 1});
-          }
-        } else {
-          typemap.insert({(*it)->ip->type,  1});
-          root->fpMap.insert({(*it)->addr->addr, typemap});
-          typemap.clear();
-        }
+        root->fpMap.add(store->addr[*it], store->type[*it]);
       }
       for (auto it = root->children.begin(); it != root->children.end(); it++){
         root->totalLoads += (*it)->totalLoads;
@@ -296,7 +246,7 @@ Trace * Function::calculateFunctionFPRec(Function *root,  int level ){
 //}
 
 Trace * Function::calculateFunctionCPUFPRec(Function *root,  int level ){
-    Trace * childTimeVec =  new Trace();
+    Trace * childTimeVec =  new Trace(root->trace->store);
     std::vector< Trace * > tempVec;
     if (root == NULL){
       return childTimeVec;
@@ -310,84 +260,49 @@ Trace * Function::calculateFunctionCPUFPRec(Function *root,  int level ){
       }
     }
     // map <unsigned long, int> functionFPMap; // will hold every new access 
-    map <unsigned long, int> funcCPUFPMap [root->ncpus]; // will hold every new access
+    TraceStore *store = root->trace->store;
+    root->ncpus = store->getNumCPUs();
+    root->cpuFPMap.resize(root->ncpus);
+    vector <map <unsigned long, int>> funcCPUFPMap(root->ncpus); // will hold every new access
 
-    map <enum Metrics,int>typemap;
-    map <unsigned long, map <enum Metrics, int>>::iterator typeMapIt;
     if (tempVec.empty()){
       for(auto it = root->trace->trace.begin(); it != root->trace->trace.end(); it++) {
-        int cpuid = (*it)->cpu->cpu;
+        int cpuid = store->cpuOf(*it);
         root->totalLoads++;
-        map <unsigned long, int>::iterator fmapIter = funcCPUFPMap[cpuid].find((*it)->addr->addr);
+        map <unsigned long, int>::iterator fmapIter = funcCPUFPMap[cpuid].find(store->addr[*it]);
         if (fmapIter != funcCPUFPMap[cpuid].end()){
           fmapIter->second++;
         } else {
-          funcCPUFPMap[cpuid].insert({(*it)->addr->addr,1});
+          funcCPUFPMap[cpuid].insert({store->addr[*it],1});
           childTimeVec->addAccess(*it);
         } 
-        typeMapIt = root->cpuFPMap[cpuid].find((*it)->addr->addr);
-        if (typeMapIt != root->cpuFPMap[cpuid].end()){
-          map <enum Metrics, int>::iterator tit = typeMapIt->second.find((*it)->ip->type);
-          if (tit != typeMapIt->second.end()){
-            tit->second++;
-          } else {
-            typeMapIt->second.insert({(*it)->ip->type, 1});
-          }
-        } else {
-          typemap.insert({(*it)->ip->type,  1});
-          root->cpuFPMap[cpuid].insert({(*it)->addr->addr, typemap});
-          typemap.clear();
-        }
+        root->cpuFPMap[cpuid].add(store->addr[*it], store->type[*it]);
       }
     } else {
       for (auto tit = tempVec.begin(); tit  != tempVec.end(); tit++){
         for(auto it = (*tit)->trace.begin(); it != (*tit)->trace.end(); it++) {
-          int cpuid = (*it)->cpu->cpu;
-          map <unsigned long, int>::iterator fmapIter = funcCPUFPMap[cpuid].find((*it)->addr->addr);
+          int cpuid = store->cpuOf(*it);
+          map <unsigned long, int>::iterator fmapIter = funcCPUFPMap[cpuid].find(store->addr[*it]);
           if (fmapIter != funcCPUFPMap[cpuid].end()){
             fmapIter->second++;
           } else {
-            funcCPUFPMap[cpuid].insert({(*it)->addr->addr,1});
+            funcCPUFPMap[cpuid].insert({store->addr[*it],1});
             childTimeVec->addAccess(*it);
           }
-          typeMapIt = root->cpuFPMap[cpuid].find((*it)->addr->addr);
-          if (typeMapIt != root->cpuFPMap[cpuid].end()){
-            map <enum Metrics, int>::iterator tit = typeMapIt->second.find((*it)->ip->type);
-            if (tit != typeMapIt->second.end()){
-              tit->second++;
-            } else {
-              typeMapIt->second.insert({(*it)->ip->type, 1});
-            }
-          } else {
-            typemap.insert({(*it)->ip->type,  1});
-            root->cpuFPMap[cpuid].insert({(*it)->addr->addr, typemap});
-            typemap.clear();
-          }
+          root->cpuFPMap[cpuid].add(store->addr[*it], store->type[*it]);
         }
       }
       for(auto it = root->trace->trace.begin(); it != root->trace->trace.end(); it++) {
-        int cpuid = (*it)->cpu->cpu;
+        int cpuid = store->cpuOf(*it);
         root->totalLoads++;
-        map <unsigned long, int>::iterator fmapIter = funcCPUFPMap[cpuid].find((*it)->addr->addr);
+        map <unsigned long, int>::iterator fmapIter = funcCPUFPMap[cpuid].find(store->addr[*it]);
         if (fmapIter != funcCPUFPMap[cpuid].end()){
-          funcCPUFPMap[cpuid].insert({(*it)->addr->addr,fmapIter->second +1});
+          funcCPUFPMap[cpuid].insert({store->addr[*it],fmapIter->second +1});
         } else {
-          funcCPUFPMap[cpuid].insert({(*it)->addr->addr,1});
+          funcCPUFPMap[cpuid].insert({store->addr[*it],1});
           childTimeVec->addAccess(*it);
         }
-        typeMapIt = root->cpuFPMap[cpuid].find((*it)->addr->addr);
-        if (typeMapIt != root->cpuFPMap[cpuid].end()){
-          map <enum Metrics, int>::iterator tit = typeMapIt->second.find((*it)->ip->type);
-          if (tit != typeMapIt->second.end()){
-            tit->second++;
-          } else {
-            typeMapIt->second.insert({(*it)->ip->type, 1});
-          }
-        } else {
-          typemap.insert({(*it)->ip->type,  1});
-          root->cpuFPMap[cpuid].insert({(*it)->addr->addr, typemap});
-          typemap.clear();
-        }
+        root->cpuFPMap[cpuid].add(store->addr[*it], store->type[*it]);
       }
       for (auto it = root->children.begin(); it != root->children.end(); it++){
         root->totalLoads += (*it)->totalLoads;
@@ -448,19 +363,19 @@ void  Function::printFunctionTreeRec(Function *root, int level ){
       uint32_t prev_sampleID = 0; 
       int total_loads_in_trace = 0;
       int total_loads_in_window = 0;
-
+      TraceStore *store = trace->store;
 
       for(auto it = trace->trace.begin(); it != trace->trace.end(); it++) {
-        total_loads_in_trace = total_loads_in_trace + 1 + (*it)->ip->getExtraFrameLds();
-        total_loads_in_window = total_loads_in_window + 1 + (*it)->ip->getExtraFrameLds();
+        total_loads_in_trace = total_loads_in_trace + 1 + store->extra_frame_lds[*it];
+        total_loads_in_window = total_loads_in_window + 1 + store->extra_frame_lds[*it];
         current_ws++;
         if (is_first){
           is_first = false;
-          window_first_time = (*it)->time->time;
-          prev_sampleID = (*it)->time->getSampleID();
+          window_first_time = store->timeOf(*it);
+          prev_sampleID = store->sampleID[*it];
         }
 //Dividing trace regarding the sampling frequency/period
-          if (prev_sampleID != (*it)->time->getSampleID()){
+          if (prev_sampleID != store->sampleID[*it]){
             new_sample = true;
           } else {
             new_sample = false;
@@ -472,9 +387,9 @@ void  Function::printFunctionTreeRec(Function *root, int level ){
            number_of_windows++;
            window_size+=current_ws;
            wSize.push_back(current_ws);
-           skip_time+=((*it)->time->time-prevTime);
-           Zt.push_back((*it)->time->time-prevTime);
-           current_ztime = ((*it)->time->time-prevTime);
+           skip_time+=(store->timeOf(*it)-prevTime);
+           Zt.push_back(store->timeOf(*it)-prevTime);
+           current_ztime = (store->timeOf(*it)-prevTime);
            unsigned long z_curr;
            if (prevTime - window_first_time){
             z_curr = (current_ws*current_ztime)/(prevTime - window_first_time);
@@ -484,14 +399,14 @@ void  Function::printFunctionTreeRec(Function *root, int level ){
            Zs.push_back(z_curr);
            window_time += prevTime - window_first_time;
            wTime.push_back(prevTime - window_first_time);
-           window_first_time =  (*it)->time->time;
+           window_first_time =  store->timeOf(*it);
            wMultipliers.push_back((double)period/(double)total_loads_in_window);
            total_loads_in_window = 0;
 
            current_ws = 0;
           }
-        prevTime = (*it)->time->time;
-        prev_sampleID =  (*it)->time->getSampleID();
+        prevTime = store->timeOf(*it);
+        prev_sampleID =  store->sampleID[*it];
       }
 
       //calculating LoadBased Multiplier versions:
@@ -37,6 +37,7 @@
 //***************************************************************************
 //#include "AccessTime.hpp"
 #include "Trace.hpp"
+#include "FPTable.hpp"
 #include "metrics.hpp"
 using namespace std;
 
@@ -45,9 +46,12 @@ namespace memgaze {
 class Function {
   public:
     int fp;
-    uint16_t ncpus;
-    std::vector<int> cpuFP;
+    int ncpus;                    // CPUs of the trace, see TraceStore::cpuList
+    std::vector<int> cpuFP;       // by compact CPU index
+    int sharedFP;                 // addresses touched by more than one CPU
+    std::vector<int> cpuSharedFP; // addresses of a CPU also touched by others
     double totalLoads;
+    int prevLoads;                // loads of earlier trace parts (incremental mode)
     std::string name;
     uint32_t nameID;
     uint16_t load_module;
@@ -57,16 +61,17 @@ class Function {
     Function * parrent;
  //OZGURCLEANUP    std::vector<AccessTime *> timeVec;
     Trace * trace;
-    map <unsigned long, map <enum Metrics,int>> fpMap; //<address < type, count>
-    std::vector <map <unsigned long, map <enum Metrics,int>>> cpuFPMap; //<address < type, count>
-    void getdiagMap (map <enum Metrics,int> *typeMap, map <enum Metrics, double> *fpDiagMap);  
+    FPTable fpMap; //<address < type, count>
+    std::vector <FPTable> cpuFPMap; //<address < type, count>
+    void getdiagMap (FPTable::Entry *typeMap, map <enum Metrics, double> *fpDiagMap);  
     void getFPDiag(map <enum Metrics, double> *diagMap); 
     void getCPUFPDiag(map <enum Metrics, double> *cpuDiagMap, uint16_t cpuid);
     int getFP();    
+    int getLoads(){ return trace->getSize() + prevLoads;}
     void calcFP();
-    void calcCPUFP();
-    Function  (std::string _name, unsigned long _s = 0,  unsigned long _e = 0, int _ncpus = 24);
-    Function  (std::string _name, uint16_t _load_module, unsigned long _s = 0,  unsigned long _e = 0, int _ncpus = 24);
+    void calcCPUFP(unsigned int nthreads = 1);
+    Function  (TraceStore *_store, std::string _name, unsigned long _s = 0,  unsigned long _e = 0);
+    Function  (TraceStore *_store, std::string _name, uint16_t _load_module, unsigned long _s = 0,  unsigned long _e = 0);
 
 //OZGURCLEANUP  DEPRICATE  ??    std::vector<AccessTime *> calculateFunctionFP(); // depricate TODO: remove/revisit
 //OZGURCLEANUP DEPRICATE ??    std::vector<AccessTime *> calculateFunctionCPUFP(); // depricated TODO: remove/revisit
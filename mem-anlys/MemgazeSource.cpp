@@ -25,8 +25,7 @@ using std::string;
 
 //*************************** User Include Files ****************************
 
-#include "Instruction.hpp"
-#include "Address.hpp"
+#include "TraceStore.hpp"
 #include "MemgazeSource.hpp"
 #include "metrics.hpp"
 
@@ -0,0 +1,53 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Runs work(i) for i in [0, n) on up to nthreads threads. Items are handed
+// out dynamically (one at a time) so uneven items balance; results must be
+// written to per-item slots so callers can consume them in index order.
+inline void parallelFor(size_t n, unsigned int nthreads, const function<void(size_t)> &work){
+  if (nthreads > n){
+    nthreads = n;
+  }
+  if (nthreads <= 1){
+    for (size_t i = 0; i < n; i++){
+      work(i);
+    }
+    return;
+  }
+  atomic <size_t> next(0);
+  vector <thread> workers;
+  for (unsigned int t = 0; t < nthreads; t++){
+    workers.push_back(thread([&](){
+      for (size_t i = next++; i < n; i = next++){
+        work(i);
+      }
+    }));
+  }
+  for (auto it = workers.begin(); it != workers.end(); it++){
+    it->join();
+  }
+}
+
+#endif
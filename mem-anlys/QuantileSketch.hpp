@@ -0,0 +1,171 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#define QSKETCH_K 1024 // capacity of the top compactor
+
+// Streaming quantile sketch (KLL compactors) for per-sample statistics.
+// Level h holds items of weight 2^h; a full level is sorted and every other
+// item is promoted to the next level. Lower levels get geometrically smaller
+// capacities, so memory is O(k log(n/k)) regardless of the number of
+// samples. Level 0 is compacted once it exceeds k items, so up to k samples
+// all items are kept and quantiles are exact. The promoted half alternates per level, which keeps the sketch
+// deterministic and unbiased.
+template <class T>
+class QuantileSketch {
+  public:
+    QuantileSketch(unsigned int _k = QSKETCH_K){
+      k = _k;
+      n = 0;
+      total = 0;
+      levels.resize(1);
+      offsets.resize(1, 0);
+    }
+
+    void add(T v){
+      n++;
+      total += v;
+      levels[0].push_back(v);
+      if (levels[0].size() > capacity(0)){
+        compress();
+      }
+    }
+
+    unsigned long count(){ return n;}
+    double sum(){ return total;}
+    bool isExact(){ return levels.size() == 1;}
+
+    // Median with the even-size convention (mean of the two middle items)
+    T median(){
+      if (n == 0){
+        return 0;
+      }
+      vector <pair<T, unsigned long>> items = sorted();
+      if (n % 2){
+        return rankOf(items, n / 2);
+      }
+      return (rankOf(items, n / 2) + rankOf(items, n / 2 - 1)) / 2;
+    }
+
+    // q in [0, 1], interpolated between the two nearest ranks
+    T quantile(double q){
+      if (n == 0){
+        return 0;
+      }
+      vector <pair<T, unsigned long>> items = sorted();
+      double r = q * (n - 1);
+      unsigned long lo = (unsigned long)r;
+      T a = rankOf(items, lo);
+      if (lo + 1 >= n){
+        return a;
+      }
+      T b = rankOf(items, lo + 1);
+      return a + (T)((b - a) * (r - lo));
+    }
+
+    // p10/p50/p90/p99
+    void printQuantiles(ostream &out){
+      out << quantile(0.10) << "/" << quantile(0.50) << "/" << quantile(0.90) << "/" << quantile(0.99);
+    }
+
+    // Sketch state for the result cache (Archive: CacheFile)
+    template <class Archive>
+    void serialize(Archive &ar){
+      ar.item(k);
+      ar.item(n);
+      ar.item(total);
+      ar.item(levels);
+      ar.item(offsets);
+    }
+
+  private:
+    unsigned int k;
+    unsigned long n;
+    double total;
+    vector <vector<T>> levels;  // level h: items of weight 2^h
+    vector <int> offsets;       // item kept at the next compaction of a level
+
+    size_t capacity(size_t h){
+      size_t depth = levels.size() - 1 - h;
+      double c = k;
+      for (size_t i = 0; i < depth; i++){
+        c *= 2.0 / 3.0;
+      }
+      return max((size_t)2, (size_t)c);
+    }
+
+    void compress(){
+      for (size_t h = 0; h < levels.size(); h++){
+        if (levels[h].size() < capacity(h)){
+          continue;
+        }
+        if (h + 1 == levels.size()){
+          levels.push_back(vector<T>());
+          offsets.push_back(0);
+        }
+        vector <T> &lvl = levels[h];
+        sort(lvl.begin(), lvl.end());
+        // an odd item out stays on this level
+        T odd = 0;
+        bool hasOdd = lvl.size() % 2;
+        if (hasOdd){
+          odd = lvl.back();
+          lvl.pop_back();
+        }
+        for (size_t i = offsets[h]; i < lvl.size(); i += 2){
+          levels[h + 1].push_back(lvl[i]);
+        }
+        offsets[h] ^= 1;
+        lvl.clear();
+        if (hasOdd){
+          lvl.push_back(odd);
+        }
+      }
+    }
+
+    vector <pair<T, unsigned long>> sorted(){
+      vector <pair<T, unsigned long>> items;
+      for (size_t h = 0; h < levels.size(); h++){
+        for (auto it = levels[h].begin(); it != levels[h].end(); it++){
+          items.push_back({*it, 1UL << h});
+        }
+      }
+      sort(items.begin(), items.end());
+      return items;
+    }
+
+    // Item at 0-based rank r of the weighted items
+    static T rankOf(vector <pair<T, unsigned long>> &items, unsigned long r){
+      unsigned long cum = 0;
+      for (auto it = items.begin(); it != items.end(); it++){
+        cum += it->second;
+        if (cum > r){
+          return it->first;
+        }
+      }
+      return items.back().first;
+    }
+};
+
+#endif
@@ -0,0 +1,466 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+//***************************************************************************
+// Report tables and their renderers: fixed-width text (-o), CSV (-oc) and
+// a binary columnar file (-ob).
+//
+// Binary columnar format
+//
+//   ReportBinHeader
+//   numTables x table:
+//     uint32_t nameLen; char name[nameLen]
+//     uint32_t numColumns; uint64_t numRows
+//     schema:  numColumns x { uint32_t nameLen; char name[nameLen]; uint32_t type }
+//     columns: numColumns x column data, in schema order
+//       REPORT_INT:    numRows x int64_t
+//       REPORT_DOUBLE: numRows x double
+//       REPORT_STRING: numRows x { uint32_t len; char bytes[len] }
+//
+// All values are little-endian as written by the host.
+//***************************************************************************
+
+#define REPORTBIN_MAGIC   "MGZREPRT"
+#define REPORTBIN_VERSION 1
+
+enum ReportType { REPORT_INT = 0, REPORT_DOUBLE = 1, REPORT_STRING = 2 };
+
+struct ReportBinHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t numTables;
+};
+
+// Output file with a large buffer; numbers are formatted straight into it
+class BufferedWriter {
+  public:
+    BufferedWriter(size_t _capacity = 1 << 20){
+      fp = NULL;
+      ok = false;
+      capacity = _capacity;
+      buf.resize(capacity);
+      used = 0;
+    }
+    ~BufferedWriter(){ close();}
+
+    bool open(string path){
+      fp = fopen(path.c_str(), "wb");
+      ok = (fp != NULL);
+      used = 0;
+      if (!ok){
+        cerr << "Error in file open - " << path << endl;
+      }
+      return ok;
+    }
+
+    // Flushes and closes; false if any write failed
+    bool close(){
+      if (fp == NULL){
+        return false;
+      }
+      flush();
+      ok = (fclose(fp) == 0) && ok;
+      fp = NULL;
+      return ok;
+    }
+
+    void write(const void *p, size_t n){
+      if (used + n > capacity){
+        flush();
+        if (n > capacity){
+          ok = ok && fwrite(p, 1, n, fp) == n;
+          return;
+        }
+      }
+      memcpy(buf.data() + used, p, n);
+      used += n;
+    }
+
+    template <class T>
+    void writeValue(T v){ write(&v, sizeof(v));}
+
+    void put(char c){ write(&c, 1);}
+    void put(const string &s){ write(s.data(), s.size());}
+
+    void putInt(int64_t v){
+      reserve(24);
+      used += snprintf(buf.data() + used, 24, "%lld", (long long)v);
+    }
+
+    // 17 significant digits read back as the same double
+    void putDouble(double v){
+      reserve(32);
+      used += snprintf(buf.data() + used, 32, "%.17g", v);
+    }
+
+  private:
+    FILE *fp;
+    bool ok;
+    size_t capacity;
+    vector <char> buf;
+    size_t used;
+
+    void flush(){
+      if (used){
+        ok = ok && fwrite(buf.data(), 1, used, fp) == used;
+        used = 0;
+      }
+    }
+    void reserve(size_t n){
+      if (used + n > capacity){
+        flush();
+      }
+    }
+};
+
+// A table of typed columns. Rows are appended cell by cell in column
+// order: t.row().put(lvl).put(fp)...
+class ReportTable {
+  public:
+    struct Column {
+      string name;
+      ReportType type;
+      bool hex;  // text only: REPORT_INT in hex (instruction pointers)
+      vector <int64_t> ints;
+      vector <double> doubles;
+      vector <string> strings;
+    };
+
+    string name;
+    vector <Column> columns;
+
+    ReportTable(string _name = ""){ name = _name; rows = 0; next = 0;}
+
+    ReportTable & column(string colName, ReportType type, bool hex = false){
+      Column c;
+      c.name = colName;
+      c.type = type;
+      c.hex = hex;
+      columns.push_back(c);
+      return *this;
+    }
+
+    ReportTable & row(){
+      assert(next == 0 || next == columns.size());
+      rows++;
+      next = 0;
+      return *this;
+    }
+
+    ReportTable & put(int64_t v){
+      Column &c = cell(REPORT_INT);
+      c.ints.push_back(v);
+      return *this;
+    }
+    ReportTable & put(int v){ return put((int64_t)v);}
+    ReportTable & put(unsigned long v){ return put((int64_t)v);}
+    ReportTable & put(double v){
+      Column &c = cell(REPORT_DOUBLE);
+      c.doubles.push_back(v);
+      return *this;
+    }
+    ReportTable & put(string v){
+      Column &c = cell(REPORT_STRING);
+      c.strings.push_back(v);
+      return *this;
+    }
+
+    uint64_t getNumRows(){ return rows;}
+
+    // Fixed-width text as in the -o report: every cell left aligned in
+    // cellsize characters, values printed by ostream; a longer cell is
+    // followed by a space
+    void printText(ostream &out, int cellsize){
+      for (size_t c = 0; c < columns.size(); c++){
+        printCell(out, cellsize, columns[c].name);
+      }
+      out << endl;
+      for (uint64_t r = 0; r < rows; r++){
+        for (size_t c = 0; c < columns.size(); c++){
+          ostringstream cell;
+          cell.precision(out.precision());
+          switch (columns[c].type){
+            case REPORT_INT:
+              if (columns[c].hex){
+                cell << std::hex;
+              }
+              cell << columns[c].ints[r];
+              break;
+            case REPORT_DOUBLE:
+              cell << columns[c].doubles[r];
+              break;
+            default:
+              cell << columns[c].strings[r];
+          }
+          printCell(out, cellsize, cell.str());
+        }
+        out << endl;
+      }
+    }
+
+    // RFC 4180 CSV with a header line
+    void writeCSV(BufferedWriter &w){
+      for (size_t c = 0; c < columns.size(); c++){
+        if (c){
+          w.put(',');
+        }
+        putCSVString(w, columns[c].name);
+      }
+      w.put('\n');
+      for (uint64_t r = 0; r < rows; r++){
+        for (size_t c = 0; c < columns.size(); c++){
+          if (c){
+            w.put(',');
+          }
+          switch (columns[c].type){
+            case REPORT_INT:
+              w.putInt(columns[c].ints[r]);
+              break;
+            case REPORT_DOUBLE:
+              w.putDouble(columns[c].doubles[r]);
+              break;
+            default:
+              putCSVString(w, columns[c].strings[r]);
+          }
+        }
+        w.put('\n');
+      }
+    }
+
+    void writeBinary(BufferedWriter &w){
+      putBinString(w, name);
+      w.writeValue((uint32_t)columns.size());
+      w.writeValue((uint64_t)rows);
+      for (size_t c = 0; c < columns.size(); c++){
+        putBinString(w, columns[c].name);
+        w.writeValue((uint32_t)columns[c].type);
+      }
+      for (size_t c = 0; c < columns.size(); c++){
+        Column &col = columns[c];
+        if (col.type == REPORT_INT){
+          w.write(col.ints.data(), col.ints.size() * sizeof(int64_t));
+        } else if (col.type == REPORT_DOUBLE){
+          w.write(col.doubles.data(), col.doubles.size() * sizeof(double));
+        } else {
+          for (auto it = col.strings.begin(); it != col.strings.end(); it++){
+            putBinString(w, *it);
+          }
+        }
+      }
+    }
+
+    // Reads a table written by writeBinary from [p, end) and advances p;
+    // false if the table does not fit
+    bool readBinary(const char *&p, const char *end){
+      uint32_t ncols;
+      uint64_t nrows;
+      if (!getBinString(p, end, name) || !getBinValue(p, end, ncols) || !getBinValue(p, end, nrows)){
+        return false;
+      }
+      columns.clear();
+      for (uint32_t c = 0; c < ncols; c++){
+        string colName;
+        uint32_t type;
+        if (!getBinString(p, end, colName) || !getBinValue(p, end, type) || type > REPORT_STRING){
+          return false;
+        }
+        column(colName, (ReportType)type);
+      }
+      for (size_t c = 0; c < columns.size(); c++){
+        Column &col = columns[c];
+        if (col.type == REPORT_STRING){
+          col.strings.resize(nrows);
+          for (uint64_t r = 0; r < nrows; r++){
+            if (!getBinString(p, end, col.strings[r])){
+              return false;
+            }
+          }
+          continue;
+        }
+        if (nrows > (uint64_t)(end - p) / 8){
+          return false;
+        }
+        if (col.type == REPORT_INT){
+          col.ints.resize(nrows);
+          memcpy(col.ints.data(), p, nrows * sizeof(int64_t));
+        } else {
+          col.doubles.resize(nrows);
+          memcpy(col.doubles.data(), p, nrows * sizeof(double));
+        }
+        p += nrows * 8;
+      }
+      rows = nrows;
+      next = columns.size();
+      return true;
+    }
+
+  private:
+    uint64_t rows;
+    size_t next; // column of the next cell
+
+    Column & cell(ReportType type){
+      assert(next < columns.size() && columns[next].type == type);
+      return columns[next++];
+    }
+
+    static void printCell(ostream &out, int cellsize, const string &s){
+      out << left << setw(cellsize) << setfill(' ') << s;
+      if ((int)s.size() >= cellsize){
+        out << ' ';
+      }
+    }
+
+    static void putCSVString(BufferedWriter &w, const string &s){
+      if (s.find_first_of(",\"\r\n") == string::npos){
+        w.put(s);
+        return;
+      }
+      w.put('"');
+      for (size_t i = 0; i < s.size(); i++){
+        if (s[i] == '"'){
+          w.put('"');
+        }
+        w.put(s[i]);
+      }
+      w.put('"');
+    }
+
+    static void putBinString(BufferedWriter &w, const string &s){
+      w.writeValue((uint32_t)s.size());
+      w.put(s);
+    }
+
+    template <class T>
+    static bool getBinValue(const char *&p, const char *end, T &v){
+      if ((size_t)(end - p) < sizeof(v)){
+        return false;
+      }
+      memcpy(&v, p, sizeof(v));
+      p += sizeof(v);
+      return true;
+    }
+
+    static bool getBinString(const char *&p, const char *end, string &s){
+      uint32_t len;
+      if (!getBinValue(p, end, len) || (size_t)(end - p) < len){
+        return false;
+      }
+      s.assign(p, len);
+      p += len;
+      return true;
+    }
+};
+
+// The tables of a run, written as one CSV file per table or one binary
+// columnar file. Tables keep their address as more are added.
+class Report {
+  public:
+    deque <ReportTable> tables;
+
+    ReportTable & addTable(string name){
+      tables.push_back(ReportTable(name));
+      return tables.back();
+    }
+
+    // <prefix>.<table>.csv
+    bool writeCSV(string prefix){
+      bool ok = true;
+      for (auto it = tables.begin(); it != tables.end(); it++){
+        string path = prefix + "." + it->name + ".csv";
+        BufferedWriter w;
+        if (!w.open(path)){
+          ok = false;
+          continue;
+        }
+        it->writeCSV(w);
+        if (!w.close()){
+          cerr << "Error writing " << path << endl;
+          ok = false;
+        }
+      }
+      return ok;
+    }
+
+    bool writeBinary(string path){
+      BufferedWriter w;
+      if (!w.open(path)){
+        return false;
+      }
+      ReportBinHeader h;
+      memset(&h, 0, sizeof(h));
+      memcpy(h.magic, REPORTBIN_MAGIC, sizeof(h.magic));
+      h.version = REPORTBIN_VERSION;
+      h.numTables = tables.size();
+      w.write(&h, sizeof(h));
+      for (auto it = tables.begin(); it != tables.end(); it++){
+        it->writeBinary(w);
+      }
+      if (!w.close()){
+        cerr << "Error writing " << path << endl;
+        return false;
+      }
+      return true;
+    }
+
+    // Replaces the tables with those of a file written by writeBinary
+    bool readBinary(string path){
+      ifstream in(path, ios::binary);
+      if (!in.is_open()){
+        cerr << "Error in file open - " << path << endl;
+        return false;
+      }
+      string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+      const char *p = data.data(), *end = data.data() + data.size();
+      ReportBinHeader h;
+      if (data.size() < sizeof(h)){
+        cerr << "Error: " << path << " is not a binary report" << endl;
+        return false;
+      }
+      memcpy(&h, p, sizeof(h));
+      p += sizeof(h);
+      if (memcmp(h.magic, REPORTBIN_MAGIC, sizeof(h.magic)) != 0 || h.version != REPORTBIN_VERSION){
+        cerr << "Error: " << path << " is not a binary report" << endl;
+        return false;
+      }
+      tables.clear();
+      for (uint32_t t = 0; t < h.numTables; t++){
+        if (!addTable("").readBinary(p, end)){
+          cerr << "Error: " << path << " has a truncated table" << endl;
+          return false;
+        }
+      }
+      return true;
+    }
+};
+
+#endif
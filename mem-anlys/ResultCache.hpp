@@ -0,0 +1,342 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+//***************************************************************************
+// Result cache (-K <dir>)
+//
+//   ResultCacheHeader
+//   payload: the items of the cached product in the order they were written
+//
+// A cache file is named '<key>.<kind>' after the content hash of the
+// inputs and options it depends on. The payload hash is checked before
+// any item is read, so a truncated or stale file is a miss, never a
+// partial load. Files are written to '<name>.tmp' and renamed.
+//***************************************************************************
+
+#define RESULTCACHE_MAGIC   "MGZCACHE"
+#define RESULTCACHE_VERSION 2
+
+struct ResultCacheHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t pad;
+  uint64_t key;
+  uint64_t payloadSize;
+  uint64_t payloadHash;
+};
+
+// 64-bit content hash, fed incrementally; bytes are mixed 8 at a time
+class ContentHash {
+  public:
+    ContentHash(uint64_t seed = 0){
+      h = seed ^ 0x9e3779b97f4a7c15ULL;
+      len = 0;
+      ntail = 0;
+    }
+
+    void add(const void *data, size_t n){
+      const unsigned char *p = (const unsigned char *)data;
+      len += n;
+      if (ntail){ // complete the word of the last call
+        size_t m = (n < 8 - ntail) ? n : 8 - ntail;
+        memcpy(tail + ntail, p, m);
+        ntail += m;
+        p += m;
+        n -= m;
+        if (ntail < 8){
+          return;
+        }
+        mixWord(tail);
+        ntail = 0;
+      }
+      for (; n >= 8; n -= 8, p += 8){
+        mixWord(p);
+      }
+      memcpy(tail, p, n);
+      ntail = n;
+    }
+
+    void add(const string &s){
+      uint64_t n = s.size();
+      add(&n, sizeof(n));
+      add(s.data(), s.size());
+    }
+
+    template <class T>
+    void addValue(T v){ add(&v, sizeof(v));}
+
+    // Adds the contents of a file, false if it cannot be read
+    bool addFile(string path){
+      FILE *fp = fopen(path.c_str(), "rb");
+      if (fp == NULL){
+        return false;
+      }
+      vector <char> buf(1 << 20);
+      size_t n;
+      while ((n = fread(buf.data(), 1, buf.size(), fp)) > 0){
+        add(buf.data(), n);
+      }
+      fclose(fp);
+      return true;
+    }
+
+    uint64_t value(){
+      unsigned char last[8] = {0};
+      memcpy(last, tail, ntail);
+      uint64_t w;
+      memcpy(&w, last, 8);
+      uint64_t x = h ^ w ^ (len * 0xff51afd7ed558ccdULL);
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdULL;
+      x ^= x >> 33;
+      x *= 0xc4ceb9fe1a85ec53ULL;
+      x ^= x >> 33;
+      return x;
+    }
+
+  private:
+    uint64_t h;
+    uint64_t len;
+    unsigned char tail[8];
+    size_t ntail;
+
+    void mixWord(const unsigned char *p){
+      uint64_t w;
+      memcpy(&w, p, 8);
+      w *= 0x87c37b91114253d5ULL;
+      w = (w << 31) | (w >> 33);
+      w *= 0x4cf5ad432745937fULL;
+      h ^= w;
+      h = (h << 27) | (h >> 37);
+      h = h * 5 + 0x52dce729;
+    }
+};
+
+// A cache file being written or read. item() writes or reads a value,
+// so one function can describe both directions of a cached product.
+class CacheFile {
+  public:
+    CacheFile(){ fp = NULL; reading = false; ok = false; size = 0;}
+    ~CacheFile(){
+      if (fp != NULL){
+        fclose(fp);
+        if (!reading){
+          remove(tmpPath.c_str());
+        }
+      }
+    }
+
+    static string pathOf(string dir, uint64_t key, string kind){
+      ostringstream ss;
+      ss << dir << "/" << hex << key << "." << kind;
+      return ss.str();
+    }
+
+    // False on a miss: no file, another key or version, or a bad payload
+    bool openRead(string _path, uint64_t key){
+      path = _path;
+      reading = true;
+      fp = fopen(path.c_str(), "rb");
+      if (fp == NULL){
+        return false;
+      }
+      ResultCacheHeader h;
+      ok = fread(&h, sizeof(h), 1, fp) == 1
+           && memcmp(h.magic, RESULTCACHE_MAGIC, sizeof(h.magic)) == 0
+           && h.version == RESULTCACHE_VERSION && h.key == key;
+      // verify the payload before anything is read from it
+      ContentHash payload;
+      vector <char> buf(1 << 20);
+      uint64_t total = 0;
+      size_t n;
+      while (ok && (n = fread(buf.data(), 1, buf.size(), fp)) > 0){
+        payload.add(buf.data(), n);
+        total += n;
+      }
+      ok = ok && total == h.payloadSize && payload.value() == h.payloadHash
+           && fseek(fp, sizeof(h), SEEK_SET) == 0;
+      if (!ok){
+        fclose(fp);
+        fp = NULL;
+      }
+      return ok;
+    }
+
+    bool openWrite(string _path, uint64_t _key){
+      path = _path;
+      tmpPath = path + ".tmp";
+      key = _key;
+      reading = false;
+      size = 0;
+      hash = ContentHash();
+      fp = fopen(tmpPath.c_str(), "wb");
+      if (fp == NULL){
+        cerr << "Error in file open - " << tmpPath << endl;
+        return false;
+      }
+      ResultCacheHeader h;
+      memset(&h, 0, sizeof(h));
+      ok = fwrite(&h, sizeof(h), 1, fp) == 1;
+      return ok;
+    }
+
+    // Completes a written file; false if anything failed
+    bool close(){
+      if (fp == NULL){
+        return false;
+      }
+      if (reading){
+        fclose(fp);
+        fp = NULL;
+        return ok;
+      }
+      ResultCacheHeader h;
+      memset(&h, 0, sizeof(h));
+      memcpy(h.magic, RESULTCACHE_MAGIC, sizeof(h.magic));
+      h.version = RESULTCACHE_VERSION;
+      h.key = key;
+      h.payloadSize = size;
+      h.payloadHash = hash.value();
+      ok = ok && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, fp) == 1;
+      ok = (fclose(fp) == 0) && ok;
+      fp = NULL;
+      if (ok){
+        ok = rename(tmpPath.c_str(), path.c_str()) == 0;
+      }
+      if (!ok){
+        remove(tmpPath.c_str());
+        cerr << "Error writing " << path << endl;
+      }
+      return ok;
+    }
+
+    bool isReading(){ return reading;}
+    string getPath(){ return path;}
+
+    // Trivially copyable values are copied, other types provide
+    // 'template <class Archive> void serialize(Archive &ar)'
+    template <class T>
+    void item(T &v){
+      value(v, typename is_trivially_copyable<T>::type());
+    }
+
+    template <class A, class B>
+    void item(pair <A, B> &p){
+      item(p.first);
+      item(p.second);
+    }
+
+    void item(string &s){
+      uint64_t n = s.size();
+      item(n);
+      if (reading){
+        s.resize(n);
+      }
+      bytes(&s[0], n);
+    }
+
+    template <class T>
+    void item(vector <T> &v){
+      uint64_t n = v.size();
+      item(n);
+      if (reading){
+        v.resize(n);
+      }
+      items(v, typename is_trivially_copyable<T>::type());
+    }
+
+    template <class K, class V>
+    void item(map <K, V> &m){
+      uint64_t n = m.size();
+      item(n);
+      if (reading){
+        m.clear();
+        for (uint64_t i = 0; i < n; i++){
+          K k;
+          V v;
+          item(k);
+          item(v);
+          m.insert({k, v});
+        }
+      } else {
+        for (auto it = m.begin(); it != m.end(); it++){
+          K k = it->first;
+          item(k);
+          item(it->second);
+        }
+      }
+    }
+
+  private:
+    FILE *fp;
+    string path, tmpPath;
+    uint64_t key;
+    bool reading;
+    bool ok;
+    uint64_t size;     // payload bytes written
+    ContentHash hash;  // of the payload written
+
+    void bytes(void *p, size_t n){
+      if (!ok || n == 0){
+        return;
+      }
+      if (reading){
+        ok = fread(p, 1, n, fp) == n;
+      } else {
+        ok = fwrite(p, 1, n, fp) == n;
+        hash.add(p, n);
+        size += n;
+      }
+    }
+
+    template <class T>
+    void value(T &v, true_type){
+      bytes(&v, sizeof(T));
+    }
+
+    template <class T>
+    void value(T &v, false_type){
+      v.serialize(*this);
+    }
+
+    template <class T>
+    void items(vector <T> &v, true_type){
+      bytes(v.data(), v.size() * sizeof(T));
+    }
+
+    template <class T>
+    void items(vector <T> &v, false_type){
+      for (size_t i = 0; i < v.size(); i++){
+        item(v[i]);
+      }
+    }
+};
+
+#endif
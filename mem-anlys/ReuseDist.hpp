@@ -0,0 +1,202 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef REUSEDIST_H
+#define REUSEDIST_H
+
+#include <stdint.h>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+//***************************************************************************
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wregister"
+#include "mrd_splay_tree.h" // bin-anlys/src/common
+#pragma GCC diagnostic pop
+#include "FuncIndex.hpp"
+#include "Parallel.hpp"
+#include "Report.hpp"
+#include "Trace.hpp"
+#include "TraceStore.hpp"
+#include "metrics.hpp"
+using namespace std;
+
+#define REUSE_NODE_CHUNK (1 << 20) // bytes per splay tree node pool chunk
+
+// Reuse-distance histogram with log2 bins: bin 0 counts distance 0 and
+// bin k distances in [2^(k-1), 2^k). First touches are counted as cold.
+class ReuseHist {
+  public:
+    unsigned long accesses;
+    unsigned long cold;
+    vector <unsigned long> bins;
+
+    ReuseHist(){ accesses = 0; cold = 0;}
+
+    static int binOf(unsigned long dist){
+      return (dist == 0) ? 0 : 64 - __builtin_clzl(dist);
+    }
+
+    void add(bool is_cold, unsigned long dist){
+      accesses++;
+      if (is_cold){
+        cold++;
+        return;
+      }
+      size_t b = binOf(dist);
+      if (b >= bins.size()){
+        bins.resize(b + 1, 0);
+      }
+      bins[b]++;
+    }
+};
+
+// Reuse distance of an address stream: the number of distinct addresses
+// touched since the previous access to the same address. Uses the MIAMI
+// reuse-distance splay tree; its nodes come from the tree's pooled allocator.
+class ReuseTracker {
+  public:
+    ReuseTracker(){ tree = new MIAMIU::MRDSplayTree<>(REUSE_NODE_CHUNK);}
+    ~ReuseTracker(){ delete tree;}
+
+    // Returns false for a first touch, else sets dist
+    bool access(unsigned long addr, unsigned long *dist){
+      unordered_map <unsigned long, void *>::iterator it = nodes.find(addr);
+      if (it == nodes.end()){
+        nodes.insert({addr, tree->cold_miss()});
+        return false;
+      }
+      *dist = tree->reuse_block(it->second);
+      return true;
+    }
+
+    // Restarts the stream; the node pool chunks and the hash buckets are
+    // kept for the next one
+    void clear(){
+      tree->clear();
+      nodes.clear();
+    }
+
+  private:
+    MIAMIU::MRDSplayTree<> *tree;
+    unordered_map <unsigned long, void *> nodes; // address -> tree node
+};
+
+// Reuse-distance histograms of the trace, in total and per function, load
+// class and CPU. Scope RD_TRACE measures reuse over the whole trace;
+// RD_SAMPLE restarts at every sample so only reuse within a sample counts.
+class ReuseAnalysis {
+  public:
+    enum { RD_TRACE = 0, RD_SAMPLE, RD_NSCOPE };
+
+    ReuseHist total[RD_NSCOPE];
+    map <int, ReuseHist> funcHist[RD_NSCOPE];          // FuncIndex function index
+    map <enum Metrics, ReuseHist> classHist[RD_NSCOPE];
+    map <uint16_t, ReuseHist> cpuHist[RD_NSCOPE];
+
+    // Computes the histograms of all scopes; scopes run on separate threads
+    void analyze(Trace *trace, FuncIndex *funcIndex, unsigned int nthreads){
+      TraceStore *store = trace->store;
+      vector <int> accessFunc; // function of each trace entry
+      accessFunc.reserve(trace->getSize());
+      for (auto it = trace->trace.begin(); it != trace->trace.end(); it++){
+        accessFunc.push_back(funcIndex->find(store->load_module[*it], store->ip[*it]));
+      }
+      parallelFor(RD_NSCOPE, nthreads, [&](size_t scope){
+        analyzeScope(scope, trace, accessFunc);
+      });
+    }
+
+    // Report table: one row per scope and group; bin 0 is distance 0,
+    // bin k distances [2^(k-1), 2^k)
+    ReportTable table(string name, FuncIndex *funcIndex){
+      size_t nbins = 0;
+      for (int s = 0; s < RD_NSCOPE; s++){
+        nbins = max(nbins, total[s].bins.size());
+      }
+      ReportTable t(name);
+      t.column("Scope", REPORT_STRING).column("Group", REPORT_STRING)
+       .column("Accesses", REPORT_INT).column("Cold", REPORT_INT);
+      for (size_t b = 0; b < nbins; b++){
+        t.column("B" + to_string(b), REPORT_INT);
+      }
+      t.column("Name", REPORT_STRING);
+      for (int s = 0; s < RD_NSCOPE; s++){
+        string scope = (s == RD_TRACE) ? "Trace" : "Sample";
+        addRow(t, scope, "All", total[s], nbins, "");
+        for (auto it = classHist[s].begin(); it != classHist[s].end(); it++){
+          addRow(t, scope, "Class", it->second, nbins, className(it->first));
+        }
+        for (auto it = cpuHist[s].begin(); it != cpuHist[s].end(); it++){
+          addRow(t, scope, "CPU", it->second, nbins, to_string(it->first));
+        }
+        for (auto it = funcHist[s].begin(); it != funcHist[s].end(); it++){
+          addRow(t, scope, "Function", it->second, nbins, funcIndex->getFunction(it->first)->name);
+        }
+      }
+      return t;
+    }
+
+  private:
+    void analyzeScope(int scope, Trace *trace, vector <int> &accessFunc){
+      TraceStore *store = trace->store;
+      ReuseTracker tracker;
+      uint32_t prevSampleID = 0;
+      for (size_t i = 0; i < trace->trace.size(); i++){
+        uint32_t a = trace->trace[i];
+        if (scope == RD_SAMPLE && i > 0 && store->sampleID[a] != prevSampleID){
+          tracker.clear();
+        }
+        prevSampleID = store->sampleID[a];
+        unsigned long dist = 0;
+        bool is_cold = !tracker.access(store->addr[a], &dist);
+        total[scope].add(is_cold, dist);
+        classHist[scope][store->type[a]].add(is_cold, dist);
+        cpuHist[scope][store->cpu[a]].add(is_cold, dist);
+        if (accessFunc[i] >= 0){
+          funcHist[scope][accessFunc[i]].add(is_cold, dist);
+        }
+      }
+    }
+
+    static string className(enum Metrics type){
+      switch (type){
+        case CONSTANT:
+          return "Constant";
+        case STRIDED:
+          return "Strided";
+        case INDIRECT:
+          return "Indirect";
+        case STORE:
+          return "Store";
+        default:
+          return "Unknown";
+      }
+    }
+
+    static void addRow(ReportTable &t, string scope, string group, ReuseHist &h,
+                       size_t nbins, string name){
+      t.row().put(scope).put(group).put(h.accesses).put(h.cold);
+      for (size_t b = 0; b < nbins; b++){
+        t.put((b < h.bins.size()) ? h.bins[b] : 0UL);
+      }
+      t.put(name);
+    }
+};
+
+#endif
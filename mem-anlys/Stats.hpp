@@ -0,0 +1,100 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef STATS_H
+#define STATS_H
+
+#include <sys/resource.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Phase timers and peak resident set size (--stats).
+// phase(name) ends the running phase and starts the next one; a phase
+// entered more than once accumulates its time. The peak RSS of a phase is
+// the process peak when it last ended.
+class PhaseStats {
+  public:
+    struct Phase {
+      string name;
+      double seconds;
+      long peakRSS; // KB
+    };
+    vector <Phase> phases; // in order of first entry
+
+    PhaseStats(){
+      start = Clock::now();
+      running = -1;
+    }
+
+    void phase(string name){
+      stop();
+      for (size_t i = 0; i < phases.size(); i++){
+        if (phases[i].name == name){
+          running = i;
+        }
+      }
+      if (running < 0){
+        phases.push_back({name, 0, 0});
+        running = phases.size() - 1;
+      }
+      t0 = Clock::now();
+    }
+
+    void stop(){
+      if (running < 0){
+        return;
+      }
+      phases[running].seconds += chrono::duration<double>(Clock::now() - t0).count();
+      phases[running].peakRSS = peakRSS();
+      running = -1;
+    }
+
+    // Peak RSS of the process so far in KB
+    static long peakRSS(){
+      struct rusage ru;
+      getrusage(RUSAGE_SELF, &ru);
+      return ru.ru_maxrss;
+    }
+
+    // Phase table and the throughput of loads over the whole run
+    void print(ostream &out, unsigned long loads, int cellsize){
+      stop();
+      double total = chrono::duration<double>(Clock::now() - start).count();
+      out << "Stats: " << left << setw(cellsize) << setfill(' ') << "Phase"
+          << left << setw(cellsize) << "Time_s"
+          << left << setw(cellsize) << "Peak_RSS_MB" << endl;
+      for (auto it = phases.begin(); it != phases.end(); it++){
+        out << "Stats: " << left << setw(cellsize) << it->name
+            << left << setw(cellsize) << it->seconds
+            << left << setw(cellsize) << it->peakRSS / 1024.0 << endl;
+      }
+      out << "Stats: " << left << setw(cellsize) << "total"
+          << left << setw(cellsize) << total
+          << left << setw(cellsize) << peakRSS() / 1024.0 << endl;
+      out << "Stats: loads " << loads << " loads/s " << (total > 0 ? loads / total : 0) << endl;
+    }
+
+  private:
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start, t0;
+    int running; // index of the running phase, -1 if none
+};
+
+#endif
@@ -36,24 +36,23 @@
 #include "metrics.hpp"
 //***************************************************************************
 //class Access;
-#include "Access.hpp"
-//***************************************************************************
+#include "TraceStore.hpp"
 using namespace std;
 
-//This class hold the access time
-//v1: hold a pointer to each other classes
-//v2: holds an array/map to CPUs
+// A Trace is an ordered list of access indices into a TraceStore
 class Trace {
   public:
-  vector<Access *> trace;
-  
+  vector<uint32_t> trace;
+  TraceStore *store;
+
+  Trace(TraceStore *_store = NULL){ store = _store;}
   ~Trace(){emptyTrace();}
   
-  vector<Access*> * getTrace(){return &trace;}
+  vector<uint32_t> * getTrace(){return &trace;}
 
   int getSize(){return trace.size();}
 
-  void addAccess(Access * access){
+  void addAccess(uint32_t access){
     trace.push_back(access);
   }
   
@@ -69,6 +68,9 @@ class Trace {
   }
   
   void addTrace(Trace * inTrace){
+    if (store == NULL){
+      store = inTrace->store;
+    }
     for (auto  it = inTrace->trace.begin(); it != inTrace->trace.end(); it++){
       this->addAccess(*it);
     }
@@ -0,0 +1,310 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef TRACEBIN_H
+#define TRACEBIN_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+//***************************************************************************
+// Binary trace format (memgaze-trace-pack)
+//
+//   TraceBinHeader
+//   DSO string table:  numDSO x { uint32_t id; uint32_t len; char name[len] }
+//   sample index:      numSamples x TraceBinSample (8-byte aligned)
+//   records:           numRecords x TraceBinRecord (8-byte aligned)
+//
+// Records hold the fields of a text trace line '<IP> <Addrs> <CPU> <time>
+// <sampleID> <DSO_id>' in the order they appear in the text trace. Time
+// is kept in nanoseconds, i.e., (unsigned long)(<time> * 1e9). A sample
+// is a maximal run of records with the same sampleID.
+//***************************************************************************
+
+#define TRACEBIN_MAGIC   "MGZTRACE"
+#define TRACEBIN_VERSION 1
+#define TRACEBIN_NO_DSO  0xffff
+
+struct TraceBinHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint64_t numRecords;
+  uint64_t numSamples;
+  uint64_t minAddr;
+  uint64_t maxAddr;
+  uint32_t numDSO;
+  uint32_t hasDSO;     // 1 if the text trace had a DSO: section
+  uint64_t dsoOffset;
+  uint64_t sampleOffset;
+  uint64_t recordOffset;
+};
+
+struct TraceBinRecord {
+  uint64_t ip;
+  uint64_t addr;
+  uint64_t time;
+  uint32_t sampleID;
+  uint16_t cpu;
+  uint16_t dso;
+};
+
+struct TraceBinSample {
+  uint64_t firstRecord;
+  uint32_t sampleID;
+  uint32_t numRecords;
+};
+
+// Returns true if 'filename' starts with the binary trace magic
+inline bool isTraceBinFile(string filename){
+  char magic[8];
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0){
+    return false;
+  }
+  ssize_t n = read(fd, magic, sizeof(magic));
+  close(fd);
+  return (n == sizeof(magic) && memcmp(magic, TRACEBIN_MAGIC, sizeof(magic)) == 0);
+}
+
+// Read-only view of a binary trace. The file is mmap'ed and records are
+// accessed in place.
+class TraceBinFile {
+  public:
+    TraceBinFile(){ base = NULL; size = 0;}
+    ~TraceBinFile(){ closeFile();}
+
+    bool openFile(string filename){
+      int fd = open(filename.c_str(), O_RDONLY);
+      if (fd < 0){
+        cerr << "Error in file open - " << filename << endl;
+        return false;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TraceBinHeader)){
+        cerr << "Error: " << filename << " is not a binary trace" << endl;
+        close(fd);
+        return false;
+      }
+      size = st.st_size;
+      void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (p == MAP_FAILED){
+        cerr << "Error in mmap - " << filename << endl;
+        base = NULL;
+        size = 0;
+        return false;
+      }
+      base = (const char *)p;
+      const TraceBinHeader *h = header();
+      if (memcmp(h->magic, TRACEBIN_MAGIC, sizeof(h->magic)) != 0
+          || h->version != TRACEBIN_VERSION
+          || h->recordSize != sizeof(TraceBinRecord)
+          || h->recordOffset > size || h->numRecords > (size - h->recordOffset) / sizeof(TraceBinRecord)
+          || h->sampleOffset > size || h->numSamples > (size - h->sampleOffset) / sizeof(TraceBinSample)){
+        cerr << "Error: " << filename << " has an unsupported binary trace version" << endl;
+        closeFile();
+        return false;
+      }
+      if (!checkDSOTable()){
+        cerr << "Error: " << filename << " has a corrupt DSO table" << endl;
+        closeFile();
+        return false;
+      }
+      madvise(p, size, MADV_SEQUENTIAL);
+      return true;
+    }
+
+    void closeFile(){
+      if (base != NULL){
+        munmap((void *)base, size);
+      }
+      base = NULL;
+      size = 0;
+    }
+
+    const TraceBinHeader * header(){ return (const TraceBinHeader *)base;}
+    uint64_t getNumRecords(){ return header()->numRecords;}
+    uint64_t getNumSamples(){ return header()->numSamples;}
+    bool hasDSO(){ return header()->hasDSO != 0;}
+    const TraceBinRecord * records(){ return (const TraceBinRecord *)(base + header()->recordOffset);}
+    const TraceBinSample * samples(){ return (const TraceBinSample *)(base + header()->sampleOffset);}
+
+    // DSO id -> name; the table is bounds-checked by openFile
+    void getDSOTable(map <uint16_t, string> *dsoMap){
+      const char *p = base + header()->dsoOffset;
+      for (uint32_t i = 0; i < header()->numDSO; i++){
+        uint32_t id, len;
+        memcpy(&id, p, sizeof(id));
+        memcpy(&len, p + sizeof(id), sizeof(len));
+        p += sizeof(id) + sizeof(len);
+        dsoMap->insert({(uint16_t)id, string(p, len)});
+        p += len;
+      }
+    }
+
+  private:
+    const char *base;
+    size_t size;
+
+    // Every DSO entry, header and name, lies within the mapped file
+    bool checkDSOTable(){
+      uint64_t off = header()->dsoOffset;
+      if (off > size){
+        return false;
+      }
+      for (uint32_t i = 0; i < header()->numDSO; i++){
+        uint32_t len;
+        if (size - off < sizeof(uint32_t) + sizeof(len)){
+          return false;
+        }
+        memcpy(&len, base + off + sizeof(uint32_t), sizeof(len));
+        off += sizeof(uint32_t) + sizeof(len);
+        if (size - off < len){
+          return false;
+        }
+        off += len;
+      }
+      return true;
+    }
+};
+
+// Writes a binary trace as the records arrive, for traces too large to
+// hold in memory. The sample index is reserved for at most maxSamples
+// samples when the file is opened and written by close().
+class TraceBinStreamWriter {
+  public:
+    TraceBinStreamWriter(){
+      fp = NULL;
+      ok = false;
+      memset(&h, 0, sizeof(h));
+    }
+    ~TraceBinStreamWriter(){
+      if (fp != NULL){
+        fclose(fp);
+      }
+    }
+
+    // DSOs are added before open
+    void addDSO(uint32_t id, string name){
+      dsoList.push_back({id, name});
+    }
+
+    bool open(string _filename, uint64_t maxSamples){
+      filename = _filename;
+      fp = fopen(filename.c_str(), "wb");
+      if (fp == NULL){
+        cerr << "Error in file open - " << filename << endl;
+        return false;
+      }
+      setvbuf(fp, NULL, _IOFBF, 1 << 20);
+      memcpy(h.magic, TRACEBIN_MAGIC, sizeof(h.magic));
+      h.version = TRACEBIN_VERSION;
+      h.recordSize = sizeof(TraceBinRecord);
+      h.minAddr = UINT64_MAX;
+      h.numDSO = dsoList.size();
+      h.hasDSO = !dsoList.empty();
+      h.dsoOffset = sizeof(TraceBinHeader);
+      uint64_t dsoSize = 0;
+      for (auto it = dsoList.begin(); it != dsoList.end(); it++){
+        dsoSize += 2 * sizeof(uint32_t) + it->second.size();
+      }
+      h.sampleOffset = align8(h.dsoOffset + dsoSize);
+      h.recordOffset = align8(h.sampleOffset + maxSamples * sizeof(TraceBinSample));
+      maxSamp = maxSamples;
+
+      ok = fwrite(&h, sizeof(h), 1, fp) == 1;
+      for (auto it = dsoList.begin(); ok && it != dsoList.end(); it++){
+        uint32_t len = it->second.size();
+        ok = fwrite(&it->first, sizeof(uint32_t), 1, fp) == 1
+             && fwrite(&len, sizeof(len), 1, fp) == 1
+             && fwrite(it->second.data(), 1, len, fp) == len;
+      }
+      ok = ok && fseek(fp, h.recordOffset, SEEK_SET) == 0;
+      return ok;
+    }
+
+    void addRecord(const TraceBinRecord &rec){
+      if (samples.empty() || samples.back().sampleID != rec.sampleID){
+        if (samples.size() == maxSamp){
+          if (ok){
+            cerr << "Error: " << filename << " has more than " << maxSamp << " samples" << endl;
+          }
+          ok = false;
+          return;
+        }
+        TraceBinSample s;
+        s.firstRecord = h.numRecords;
+        s.sampleID = rec.sampleID;
+        s.numRecords = 0;
+        samples.push_back(s);
+      }
+      samples.back().numRecords++;
+      if (rec.addr < h.minAddr) h.minAddr = rec.addr;
+      if (rec.addr > h.maxAddr) h.maxAddr = rec.addr;
+      h.numRecords++;
+      ok = ok && fwrite(&rec, sizeof(rec), 1, fp) == 1;
+    }
+
+    // Writes the sample index and the header; false if anything failed
+    bool close(){
+      if (fp == NULL){
+        return false;
+      }
+      h.numSamples = samples.size();
+      if (h.numRecords == 0){
+        h.minAddr = 0;
+      }
+      ok = ok && fseek(fp, h.sampleOffset, SEEK_SET) == 0
+           && fwrite(samples.data(), sizeof(TraceBinSample), samples.size(), fp) == samples.size()
+           && fseek(fp, 0, SEEK_SET) == 0
+           && fwrite(&h, sizeof(h), 1, fp) == 1;
+      ok = (fclose(fp) == 0) && ok;
+      fp = NULL;
+      if (!ok){
+        cerr << "Error writing " << filename << endl;
+      }
+      return ok;
+    }
+
+    uint64_t getNumRecords(){ return h.numRecords;}
+    uint64_t getNumSamples(){ return samples.size();}
+
+  private:
+    FILE *fp;
+    string filename;
+    bool ok;
+    TraceBinHeader h;
+    uint64_t maxSamp;
+    vector <pair<uint32_t, string>> dsoList;
+    vector <TraceBinSample> samples;
+
+    static uint64_t align8(uint64_t off){ return (off + 7) & ~(uint64_t)7;}
+};
+
+#endif
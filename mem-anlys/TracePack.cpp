@@ -0,0 +1,73 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// memgaze-trace-pack: convert a text trace (memgaze-xtrace-normalize
+// output) into the binary trace format read by memgaze-analyze and
+// memgaze-analyze-loc (see TraceBin.hpp).
+//***************************************************************************
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+//***************************************************************************
+#include "TraceBin.hpp"
+#include "TraceParse.hpp"
+//***************************************************************************
+using namespace std;
+
+int main(int argc, char* argv[]) {
+  if (argc != 3 || string(argv[1]) == "-h"){
+    cout << "Usage: memgaze-trace-pack <input.trace> <output.trace.bin>\n"
+         << "Convert a text trace into the binary trace format." << endl;
+    return 1;
+  }
+  string inputFile = argv[1];
+  string outputFile = argv[2];
+
+  TraceTextParser textTrace;
+  if (!textTrace.parseFile(inputFile, std::thread::hardware_concurrency())){
+    return 1;
+  }
+
+  // Records are written as they are taken from the parser chunks, and
+  // each chunk is freed once written, so the trace is held only once
+  TraceBinStreamWriter writer;
+  for (auto it = textTrace.dsoMap.begin(); it != textTrace.dsoMap.end(); it++){
+    writer.addDSO(it->first, it->second);
+  }
+  if (!writer.open(outputFile, textTrace.getNumSamples())){
+    return 1;
+  }
+  for (auto cit = textTrace.chunks.begin(); cit != textTrace.chunks.end(); cit++){
+    for (auto rit = cit->begin(); rit != cit->end(); rit++){
+      writer.addRecord(*rit);
+    }
+    vector<TraceBinRecord>().swap(*cit);
+  }
+  unsigned long skipped = textTrace.skipped;
+
+  if (!writer.close()){
+    return 1;
+  }
+  cout << "Packed " << writer.getNumRecords() << " records in "
+       << writer.getNumSamples() << " samples into " << outputFile;
+  if (skipped){
+    cout << " (skipped " << skipped << " malformed lines)";
+  }
+  cout << endl;
+  return 0;
+}
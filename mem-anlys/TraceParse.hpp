@@ -0,0 +1,285 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef TRACEPARSE_H
+#define TRACEPARSE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TraceBin.hpp"
+using namespace std;
+
+//***************************************************************************
+// Parallel parser for text traces (memgaze-xtrace-normalize output)
+//
+// The DSO:/TRACE: header is read serially. The trace body is split at
+// newline boundaries into one chunk per thread; every thread scans its
+// chunk in place into TraceBinRecords. Chunks are kept in file order so
+// the caller can merge them in order.
+//***************************************************************************
+
+#define TRACEPARSE_MIN_CHUNK (1 << 20) // smallest body chunk given to a thread
+
+class TraceTextParser {
+  public:
+    vector <vector<TraceBinRecord>> chunks; // records of each chunk, in file order
+    map <uint16_t, string> dsoMap;
+    bool anyLM;
+    unsigned long skipped;                  // malformed trace lines
+
+    TraceTextParser(){
+      anyLM = false;
+      skipped = 0;
+    }
+
+    bool parseFile(string filename, unsigned int nthreads){
+      int fd = open(filename.c_str(), O_RDONLY);
+      if (fd < 0){
+        cerr << "Error in file open - " << filename << endl;
+        return false;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0){
+        close(fd);
+        return false;
+      }
+      size_t size = st.st_size;
+      if (size == 0){
+        close(fd);
+        return true;
+      }
+      void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (p == MAP_FAILED){
+        cerr << "Error in mmap - " << filename << endl;
+        return false;
+      }
+      madvise(p, size, MADV_SEQUENTIAL);
+      const char *base = (const char *)p;
+      const char *end = base + size;
+
+      const char *body = parseHeader(base, end);
+
+      // Split the body at newline boundaries
+      size_t bodySize = end - body;
+      if (nthreads < 1){
+        nthreads = 1;
+      }
+      if (bodySize / TRACEPARSE_MIN_CHUNK + 1 < nthreads){
+        nthreads = bodySize / TRACEPARSE_MIN_CHUNK + 1;
+      }
+      vector <const char *> bounds;
+      bounds.push_back(body);
+      for (unsigned int i = 1; i < nthreads; i++){
+        const char *b = body + bodySize * i / nthreads;
+        if (b < bounds.back()){
+          b = bounds.back();
+        }
+        b = (const char *)memchr(b, '\n', end - b);
+        b = (b == NULL) ? end : b + 1;
+        bounds.push_back(b);
+      }
+      bounds.push_back(end);
+
+      chunks.resize(nthreads);
+      vector <unsigned long> chunkSkipped(nthreads, 0);
+      if (nthreads == 1){
+        parseChunk(bounds[0], bounds[1], &chunks[0], &chunkSkipped[0]);
+      } else {
+        vector <thread> workers;
+        for (unsigned int i = 0; i < nthreads; i++){
+          workers.push_back(thread(&TraceTextParser::parseChunk, this,
+                                   bounds[i], bounds[i+1], &chunks[i], &chunkSkipped[i]));
+        }
+        for (auto it = workers.begin(); it != workers.end(); it++){
+          it->join();
+        }
+      }
+      for (unsigned int i = 0; i < nthreads; i++){
+        skipped += chunkSkipped[i];
+      }
+      munmap(p, size);
+      return true;
+    }
+
+    uint64_t getNumRecords(){
+      uint64_t n = 0;
+      for (auto it = chunks.begin(); it != chunks.end(); it++){
+        n += it->size();
+      }
+      return n;
+    }
+
+    // Maximal runs of records with the same sampleID, over all chunks
+    uint64_t getNumSamples(){
+      uint64_t n = 0;
+      bool first = true;
+      uint32_t prev = 0;
+      for (auto it = chunks.begin(); it != chunks.end(); it++){
+        for (auto rit = it->begin(); rit != it->end(); rit++){
+          if (first || rit->sampleID != prev){
+            n++;
+          }
+          first = false;
+          prev = rit->sampleID;
+        }
+      }
+      return n;
+    }
+
+  private:
+    static bool lineHas(const char *b, const char *e, const char *key){
+      size_t n = strlen(key);
+      for (const char *s = b; s + n <= e; s++){
+        if (memcmp(s, key, n) == 0){
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Reads the DSO:/TRACE: header with the same section rules as the
+    // serial readers and returns the start of the trace body
+    const char * parseHeader(const char *p, const char *end){
+      bool isLM = false;
+      while (p < end){
+        const char *e = (const char *)memchr(p, '\n', end - p);
+        const char *next = (e == NULL) ? end : e + 1;
+        if (e == NULL){
+          e = end;
+        }
+        if (lineHas(p, e, "DSO:")){
+          isLM = true;
+        } else if (lineHas(p, e, "TRACE:")){
+          return next;
+        } else if (isLM){
+          const char *s = p;
+          const char *name = s;
+          while (s < e && *s != ' ') s++;
+          string dsoName(name, s - name);
+          uint64_t id;
+          skipBlanks(s, e);
+          if (scanDec(s, e, id)){
+            dsoMap.insert({(uint16_t)id, dsoName});
+            anyLM = true;
+          }
+        } else {
+          return p; // trace without DSO:/TRACE: sections
+        }
+        p = next;
+      }
+      return end;
+    }
+
+    static inline void skipBlanks(const char *&p, const char *e){
+      while (p < e && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    }
+
+    static inline bool scanHex(const char *&p, const char *e, uint64_t &v){
+      if (p + 1 < e && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')){
+        p += 2;
+      }
+      const char *s = p;
+      v = 0;
+      for (; p < e; p++){
+        char c = *p;
+        if (c >= '0' && c <= '9') v = (v << 4) | (c - '0');
+        else if (c >= 'a' && c <= 'f') v = (v << 4) | (c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v = (v << 4) | (c - 'A' + 10);
+        else break;
+      }
+      return p != s;
+    }
+
+    static inline bool scanDec(const char *&p, const char *e, uint64_t &v){
+      const char *s = p;
+      v = 0;
+      for (; p < e && *p >= '0' && *p <= '9'; p++){
+        v = v * 10 + (*p - '0');
+      }
+      return p != s;
+    }
+
+    // <time> in seconds -> nanoseconds; converted as stold(<time>) * 1e9
+    // so results match the serial reader
+    static inline bool scanTime(const char *&p, const char *e, uint64_t &v){
+      char buf[64];
+      size_t n = 0;
+      while (p < e && *p != ' ' && *p != '\t' && *p != '\r' && n < sizeof(buf) - 1){
+        buf[n++] = *p++;
+      }
+      buf[n] = '\0';
+      char *bend;
+      long double t = strtold(buf, &bend);
+      if (n == 0 || bend == buf){
+        return false;
+      }
+      v = (unsigned long)(t * 1000000000);
+      return true;
+    }
+
+    // <IP> <Addrs> <CPU> <time> [<sampleID> [<DSO_id>]]
+    void parseChunk(const char *p, const char *end, vector<TraceBinRecord> *recs,
+                    unsigned long *nskipped){
+      recs->reserve((end - p) / 48 + 1);
+      TraceBinRecord rec;
+      uint64_t v = 0;
+      while (p < end){
+        const char *e = (const char *)memchr(p, '\n', end - p);
+        const char *next = (e == NULL) ? end : e + 1;
+        if (e == NULL){
+          e = end;
+        }
+        skipBlanks(p, e);
+        if (p == e){
+          p = next; // empty line
+          continue;
+        }
+        bool ok = scanHex(p, e, rec.ip);
+        skipBlanks(p, e);
+        ok = ok && scanHex(p, e, rec.addr);
+        skipBlanks(p, e);
+        ok = ok && scanDec(p, e, v);
+        rec.cpu = (uint16_t)v;
+        skipBlanks(p, e);
+        ok = ok && scanTime(p, e, rec.time);
+        if (ok){
+          skipBlanks(p, e);
+          rec.sampleID = scanDec(p, e, v) ? (uint32_t)v : 0;
+          skipBlanks(p, e);
+          rec.dso = (anyLM && scanDec(p, e, v)) ? (uint16_t)v : TRACEBIN_NO_DSO;
+          recs->push_back(rec);
+        } else {
+          (*nskipped)++;
+        }
+        p = next;
+      }
+    }
+};
+
+#endif
@@ -0,0 +1,183 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+#ifndef TRACESTORE_H
+#define TRACESTORE_H
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "metrics.hpp"
+using namespace std;
+
+#define TRACESTORE_WIDE_TIME UINT32_MAX // timeDelta: time is in wideTime
+
+// Columnar (struct-of-arrays) storage for every load of the trace.
+// An access is identified by its index in the columns; Trace, Window and
+// Function only keep indices into the store, so no per-access objects are
+// allocated. Load module and function names live in string tables and are
+// referenced by ID.
+// An access takes 32 B: time is kept as a 32-bit offset from the first
+// access of its sample (timeOf), in the rare case that does not fit the
+// time is kept in wideTime.
+class TraceStore {
+  public:
+    vector<unsigned long> ip;
+    vector<unsigned long> addr;
+    vector<uint32_t> timeDelta;
+    vector<uint32_t> sampleID;
+    vector<uint16_t> cpu;
+    vector<uint16_t> load_module;
+    vector<uint16_t> extra_frame_lds;
+    vector<enum Metrics> type;
+
+    vector<unsigned long> sampleTime;        // time of the first access of a sample
+    map<uint32_t, unsigned long> wideTime;   // access -> time, if timeDelta is TRACESTORE_WIDE_TIME
+
+    // Interned tables: load module id <-> name, function id <-> name
+    map <uint16_t, string> lmMap;
+    map <string, uint16_t> reverselmMap;
+    vector <string> funcNames;
+    map <string, uint32_t> reverseFuncMap;
+
+    // CPUs present in the trace in ascending order and the compact index of
+    // each CPU id; set by indexCPUs once the trace is read
+    vector <uint16_t> cpuList;
+    vector <uint16_t> cpuIndex;
+
+    uint32_t addAccess(unsigned long _ip, uint16_t _cpu, unsigned long _addr,
+                       unsigned long _time, uint32_t _sampleID, enum Metrics _type,
+                       uint16_t _extra_frame_lds, uint16_t _load_module){
+      if (_sampleID >= sampleTime.size()){
+        sampleTime.resize(_sampleID + 1, _time);
+      }
+      unsigned long base = sampleTime[_sampleID];
+      if (_time >= base && _time - base < TRACESTORE_WIDE_TIME){
+        timeDelta.push_back(_time - base);
+      } else {
+        timeDelta.push_back(TRACESTORE_WIDE_TIME);
+        wideTime.insert({ip.size(), _time});
+      }
+      ip.push_back(_ip);
+      addr.push_back(_addr);
+      sampleID.push_back(_sampleID);
+      cpu.push_back(_cpu);
+      load_module.push_back(_load_module);
+      extra_frame_lds.push_back(_extra_frame_lds);
+      type.push_back(_type);
+      return ip.size() - 1;
+    }
+
+    void reserve(size_t n){
+      ip.reserve(n);
+      addr.reserve(n);
+      timeDelta.reserve(n);
+      sampleID.reserve(n);
+      cpu.reserve(n);
+      load_module.reserve(n);
+      extra_frame_lds.reserve(n);
+      type.reserve(n);
+    }
+
+    size_t getSize(){return ip.size();}
+
+    unsigned long timeOf(uint32_t a){
+      if (timeDelta[a] == TRACESTORE_WIDE_TIME){
+        return wideTime.find(a)->second;
+      }
+      return sampleTime[sampleID[a]] + timeDelta[a];
+    }
+
+    // Ingested columns and the load module table, for the result cache
+    // (Archive: CacheFile). Function names come from the hpcstruct files,
+    // so they are not cached.
+    template <class Archive>
+    void serialize(Archive &ar){
+      ar.item(ip);
+      ar.item(addr);
+      ar.item(timeDelta);
+      ar.item(sampleTime);
+      ar.item(wideTime);
+      ar.item(sampleID);
+      ar.item(cpu);
+      ar.item(load_module);
+      ar.item(extra_frame_lds);
+      ar.item(type);
+      ar.item(lmMap);
+      if (ar.isReading()){
+        reverselmMap.clear();
+        for (auto it = lmMap.begin(); it != lmMap.end(); it++){
+          reverselmMap.insert({it->second, it->first});
+        }
+      }
+    }
+
+    // known: CPUs of earlier trace parts (incremental mode), indexed as if
+    // present in this trace
+    void indexCPUs(const vector <uint16_t> &known = vector <uint16_t>()){
+      vector <bool> seen;
+      for (auto it = known.begin(); it != known.end(); it++){
+        if (*it >= seen.size()){
+          seen.resize(*it + 1, false);
+        }
+        seen[*it] = true;
+      }
+      for (auto it = cpu.begin(); it != cpu.end(); it++){
+        if (*it >= seen.size()){
+          seen.resize(*it + 1, false);
+        }
+        seen[*it] = true;
+      }
+      cpuList.clear();
+      cpuIndex.assign(seen.size(), 0);
+      for (size_t c = 0; c < seen.size(); c++){
+        if (seen[c]){
+          cpuIndex[c] = cpuList.size();
+          cpuList.push_back(c);
+        }
+      }
+    }
+    size_t getNumCPUs(){ return cpuList.size();}
+    uint16_t cpuOf(uint32_t a){ return cpuIndex[cpu[a]];} // compact CPU of an access
+
+    void addLoadModule(uint16_t id, string name){
+      lmMap.insert({id, name});
+      reverselmMap.insert({name, id});
+    }
+    string getLoadModule(uint16_t id){
+      map <uint16_t, string>::iterator it = lmMap.find(id);
+      if (it == lmMap.end()){
+        return "UNKNOWN";
+      }
+      return it->second;
+    }
+
+    uint32_t internFunction(string name){
+      map <string, uint32_t>::iterator it = reverseFuncMap.find(name);
+      if (it != reverseFuncMap.end()){
+        return it->second;
+      }
+      uint32_t id = funcNames.size();
+      funcNames.push_back(name);
+      reverseFuncMap.insert({name, id});
+      return id;
+    }
+    string getFuncName(uint32_t id){ return funcNames[id];}
+};
+
+#endif
@@ -0,0 +1,357 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// memgaze-trace-synth: write a synthetic sampled trace of any size, with
+// the .binanlys and .hpcstruct files memgaze-analyze reads with it. The
+// trace is a DSO:/TRACE: text trace or, with -B, a binary trace (see
+// TraceBin.hpp); both are also read by memgaze-analyze-loc. Used to
+// measure analysis scaling without PT hardware (check/Makefile 'bench').
+//
+// The synthetic program has one function per pattern of -P; a CPU runs
+// the functions in turn, one per sample. Every function has SYNTH_IPS
+// load instructions and, except 'stack', its own data region of -f bytes:
+//   strided  unit-stride sweep that wraps at the end of the region; every
+//            CPU sweeps its own part and the unsampled loads between its
+//            samples (-p) advance it too
+//   gather   independent random loads (indirect) over the region
+//   hot      as gather, 90% of the loads in the first 10% of the region
+//   chase    pointer chasing: one load per SYNTH_NODE node, the nodes
+//            visited in a fixed pseudo-random cyclic order
+//   stack    frame loads in the stack frame of the CPU; the load class
+//            file gives SYNTH_FRAME_LDS more untraced frame loads per load
+// Samples of -c CPUs are interleaved in time. A sample holds -w loads or
+// the loads a PT buffer of -b bytes holds, at SYNTH_LOAD_BYTES per load.
+// With -L every other function is in a second load module, a shared
+// library mapped at SYNTH_LIB_TEXT with its own <base>-lib.hpcstruct.
+//***************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+//***************************************************************************
+#include "TraceBin.hpp"
+//***************************************************************************
+using namespace std;
+
+#define SYNTH_IPS        8
+#define SYNTH_TEXT       0x401000UL      // code of function f at SYNTH_TEXT + f * 0x100
+#define SYNTH_DATA       0x10000000UL    // first data region
+#define SYNTH_STACK      0x7ffc00000000UL // stack top of CPU 0
+#define SYNTH_STACK_SIZE 0x800000UL      // stacks of CPUs c, c+1 are this far apart
+#define SYNTH_FRAME      32              // words in a stack frame
+#define SYNTH_FRAME_LDS  2
+#define SYNTH_NODE       64              // bytes of a pointer chasing node
+#define SYNTH_WORD       8
+#define SYNTH_LOAD_BYTES 16              // PT buffer bytes of a load (ptwrite and timing)
+#define SYNTH_DSO_ID     1
+#define SYNTH_LIB_TEXT   0x7f0000001000UL // code of the -L library functions
+#define SYNTH_LIB_DSO_ID 2
+#define SYNTH_LIB_NAME   "libsynth.so"
+
+enum SynthPattern { PAT_STRIDED, PAT_GATHER, PAT_HOT, PAT_CHASE, PAT_STACK };
+
+struct PatternInfo {
+  const char *name;
+  int type;      // load class: 0 CONSTANT, 1 STRIDED, 2 INDIRECT
+  int frameLds;  // untraced frame loads per load
+};
+
+static const PatternInfo patternInfo[] = {
+  {"strided", 1, 0},
+  {"gather",  2, 0},
+  {"hot",     2, 0},
+  {"chase",   2, 0},
+  {"stack",   0, SYNTH_FRAME_LDS}
+};
+
+struct SynthFunc {
+  SynthPattern pattern;
+  string name;
+  unsigned long data;  // data region
+  unsigned long text;  // code [text, text + 0x100)
+  uint16_t dso;
+};
+
+static unsigned long loadIP(SynthFunc &f, int i){
+  return f.text + 0x10 + i * 4;
+}
+
+// A bijection on [0, n): an invertible mix on the next power of two,
+// repeated until the value falls in range (cycle walking)
+class Permutation {
+  public:
+    Permutation(unsigned long _n, unsigned long seed){
+      n = _n;
+      bits = 1;
+      while ((1UL << bits) < n){
+        bits++;
+      }
+      mask = (bits >= 64) ? ~0UL : (1UL << bits) - 1;
+      mul = (seed * 0x9e3779b97f4a7c15UL) | 1;
+    }
+
+    unsigned long operator()(unsigned long x){
+      do {
+        x = (x * mul) & mask;
+        x ^= x >> (bits / 2 + 1);
+        x = (x * 0xff51afd7ed558ccdUL) & mask;
+      } while (x >= n);
+      return x;
+    }
+
+  private:
+    unsigned long n, mask, mul;
+    int bits;
+};
+
+// hpcstruct of the functions of load module dso
+static bool writeStruct(string path, vector <SynthFunc> &funcs, uint16_t dso, string lmName){
+  FILE *fp = fopen(path.c_str(), "w");
+  if (fp == NULL){
+    cerr << "Error in file open - " << path << endl;
+    return false;
+  }
+  fprintf(fp, "<?xml version=\"1.0\"?>\n");
+  fprintf(fp, "<HPCToolkitStructure i=\"0\" version=\"4.7\" n=\"\">\n");
+  fprintf(fp, "<LM i=\"1\" n=\"%s\" v=\"{}\">\n", lmName.c_str());
+  fprintf(fp, "  <F i=\"2\" n=\"synth.c\">\n");
+  for (size_t f = 0; f < funcs.size(); f++){
+    if (funcs[f].dso != dso){
+      continue;
+    }
+    unsigned long lo = funcs[f].text;
+    fprintf(fp, "    <P i=\"%d\" n=\"%s [%s]\" ln=\"%s\" l=\"%d\" v=\"{[0x%lx-0x%lx)}\">\n",
+            (int)(3 + f), funcs[f].name.c_str(), lmName.c_str(), funcs[f].name.c_str(), (int)(1 + f * 10), lo, lo + 0x100);
+    fprintf(fp, "    </P>\n");
+  }
+  fprintf(fp, "  </F>\n");
+  fprintf(fp, "</LM>\n");
+  fprintf(fp, "</HPCToolkitStructure>\n");
+  return fclose(fp) == 0;
+}
+
+static bool writeLoadClass(string path, vector <SynthFunc> &funcs){
+  FILE *fp = fopen(path.c_str(), "w");
+  if (fp == NULL){
+    cerr << "Error in file open - " << path << endl;
+    return false;
+  }
+  for (size_t f = 0; f < funcs.size(); f++){
+    const PatternInfo &pi = patternInfo[funcs[f].pattern];
+    for (int i = 0; i < SYNTH_IPS; i++){
+      fprintf(fp, "0x%lx %d 0x0 0x%x 0x%x\n", loadIP(funcs[f], i), pi.type, SYNTH_WORD, pi.frameLds);
+    }
+  }
+  return fclose(fp) == 0;
+}
+
+static void usage(){
+  cout << "Usage: memgaze-trace-synth -o <base> [options]\n"
+       << "Write a synthetic trace <base>.trace (<base>.trace.bin with -B) with\n"
+       << "<base>.binanlys and <base>.hpcstruct.\n"
+       << " -n Samples (default 10000)\n"
+       << " -w Loads per sample (default 256)\n"
+       << " -b PT buffer size in bytes, sets the loads per sample\n"
+       << " -p Period: loads per sample interval of a CPU, sampled or not (default 10000)\n"
+       << " -P Patterns, one function each: strided, gather, hot, chase, stack\n"
+       << "    (default strided,gather,chase,stack)\n"
+       << " -f Data region of a pattern in bytes (default 67108864)\n"
+       << " -c CPUs (default 1)\n"
+       << " -r Random seed (default 1)\n"
+       << " -L Every other function in the shared library " SYNTH_LIB_NAME ",\n"
+       << "    described by <base>-lib.hpcstruct\n"
+       << " -B Binary trace\n"
+       << " -h Help" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  string base, patterns = "strided,gather,chase,stack";
+  unsigned long samples = 10000, window = 256, period = 10000;
+  unsigned long footprint = 64UL << 20, seed = 1, ncpus = 1;
+  bool binary = false, library = false;
+  int c;
+  while ((c = getopt(argc, argv, "o:n:w:b:p:P:f:c:r:LBh")) != -1){
+    switch (c){
+      case 'o': base = optarg; break;
+      case 'n': samples = strtoul(optarg, NULL, 0); break;
+      case 'w': window = strtoul(optarg, NULL, 0); break;
+      case 'b': window = strtoul(optarg, NULL, 0) / SYNTH_LOAD_BYTES; break;
+      case 'p': period = strtoul(optarg, NULL, 0); break;
+      case 'P': patterns = optarg; break;
+      case 'f': footprint = strtoul(optarg, NULL, 0); break;
+      case 'c': ncpus = strtoul(optarg, NULL, 0); break;
+      case 'r': seed = strtoul(optarg, NULL, 0); break;
+      case 'L': library = true; break;
+      case 'B': binary = true; break;
+      default:
+        usage();
+        return 1;
+    }
+  }
+  footprint = footprint / SYNTH_NODE * SYNTH_NODE;
+  if (base.empty() || window == 0 || ncpus == 0 || ncpus > 0xffff
+      || footprint < 10 * SYNTH_NODE){
+    usage();
+    return 1;
+  }
+  if (period < window){
+    period = window;
+  }
+
+  vector <SynthFunc> funcs;
+  unsigned long data = SYNTH_DATA;
+  istringstream patternList(patterns);
+  string pattern;
+  while (getline(patternList, pattern, ',')){
+    size_t p = 0;
+    while (p < sizeof(patternInfo) / sizeof(patternInfo[0]) && pattern != patternInfo[p].name){
+      p++;
+    }
+    if (p == sizeof(patternInfo) / sizeof(patternInfo[0])){
+      cerr << "Error: unknown pattern " << pattern << endl;
+      return 1;
+    }
+    SynthFunc f;
+    f.pattern = (SynthPattern)p;
+    f.name = "synth_" + pattern + "_" + to_string(funcs.size());
+    f.data = 0;
+    f.dso = (library && funcs.size() % 2 == 1) ? SYNTH_LIB_DSO_ID : SYNTH_DSO_ID;
+    f.text = (f.dso == SYNTH_LIB_DSO_ID) ? SYNTH_LIB_TEXT + funcs.size() / 2 * 0x100
+                                         : SYNTH_TEXT + (library ? funcs.size() / 2 : funcs.size()) * 0x100;
+    if (f.pattern != PAT_STACK){
+      f.data = data;
+      data += (footprint + 0xfffff) & ~0xfffffUL;
+    }
+    funcs.push_back(f);
+  }
+  if (funcs.empty() || data > SYNTH_STACK - ncpus * SYNTH_STACK_SIZE){
+    usage();
+    return 1;
+  }
+
+  if (!writeStruct(base + ".hpcstruct", funcs, SYNTH_DSO_ID, "synth") || !writeLoadClass(base + ".binanlys", funcs)){
+    return 1;
+  }
+  if (library && !writeStruct(base + "-lib.hpcstruct", funcs, SYNTH_LIB_DSO_ID, SYNTH_LIB_NAME)){
+    return 1;
+  }
+
+  string traceFile = base + (binary ? ".trace.bin" : ".trace");
+  FILE *fp = NULL;
+  TraceBinStreamWriter writer;
+  if (binary){
+    writer.addDSO(SYNTH_DSO_ID, "synth");
+    if (library){
+      writer.addDSO(SYNTH_LIB_DSO_ID, SYNTH_LIB_NAME);
+    }
+    if (!writer.open(traceFile, samples)){
+      return 1;
+    }
+  } else {
+    fp = fopen(traceFile.c_str(), "w");
+    if (fp == NULL){
+      cerr << "Error in file open - " << traceFile << endl;
+      return 1;
+    }
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+    fprintf(fp, "DSO:\nsynth %d\n", SYNTH_DSO_ID);
+    if (library){
+      fprintf(fp, "%s %d\n", SYNTH_LIB_NAME, SYNTH_LIB_DSO_ID);
+    }
+    fprintf(fp, "TRACE:\n");
+  }
+
+  mt19937_64 rng(seed);
+  unsigned long words = footprint / SYNTH_WORD;
+  unsigned long hotWords = words / 10;
+  unsigned long nodes = footprint / SYNTH_NODE;
+  uniform_int_distribution<unsigned long> anyWord(0, words - 1);
+  uniform_int_distribution<unsigned long> hotWord(0, hotWords - 1);
+  uniform_int_distribution<unsigned long> coldWord(hotWords, words - 1);
+  uniform_int_distribution<unsigned long> frameWord(1, SYNTH_FRAME);
+  uniform_int_distribution<int> percent(0, 99);
+  Permutation chaseOrder(nodes, seed);
+
+  // per CPU and function: strided word or chase step
+  vector <vector <unsigned long>> cursor(ncpus, vector <unsigned long>(funcs.size()));
+  for (unsigned long cpu = 0; cpu < ncpus; cpu++){
+    for (size_t f = 0; f < funcs.size(); f++){
+      cursor[cpu][f] = (funcs[f].pattern == PAT_CHASE) ? cpu * (nodes / ncpus) : cpu * (words / ncpus);
+    }
+  }
+  const unsigned long t0 = 1000000000000UL; // ns; a CPU does one load per ns
+
+  TraceBinRecord rec;
+  for (unsigned long s = 0; s < samples; s++){
+    unsigned long cpu = s % ncpus, j = s / ncpus;
+    int f = j % funcs.size();
+    unsigned long &cur = cursor[cpu][f];
+    unsigned long time = t0 + j * period + cpu * (period / ncpus);
+    for (unsigned long l = 0; l < window; l++, time++){
+      unsigned long addr;
+      switch (funcs[f].pattern){
+        case PAT_STRIDED:
+          addr = funcs[f].data + cur * SYNTH_WORD;
+          cur = (cur + 1) % words;
+          break;
+        case PAT_GATHER:
+          addr = funcs[f].data + anyWord(rng) * SYNTH_WORD;
+          break;
+        case PAT_HOT:
+          addr = funcs[f].data + ((percent(rng) < 90) ? hotWord(rng) : coldWord(rng)) * SYNTH_WORD;
+          break;
+        case PAT_CHASE:
+          addr = funcs[f].data + chaseOrder(cur) * SYNTH_NODE;
+          cur = (cur + 1) % nodes;
+          break;
+        default:
+          addr = SYNTH_STACK - cpu * SYNTH_STACK_SIZE - frameWord(rng) * SYNTH_WORD;
+      }
+      if (binary){
+        rec.ip = loadIP(funcs[f], l % SYNTH_IPS);
+        rec.dso = funcs[f].dso;
+        rec.addr = addr;
+        rec.time = time;
+        rec.sampleID = s + 1;
+        rec.cpu = cpu;
+        writer.addRecord(rec);
+      } else {
+        fprintf(fp, "0x%lx 0x%lx %lu %lu.%09lu %lu %d\n", loadIP(funcs[f], l % SYNTH_IPS), addr, cpu,
+                time / 1000000000UL, time % 1000000000UL, s + 1, (int)funcs[f].dso);
+      }
+    }
+    // the unsampled loads of the interval
+    if (funcs[f].pattern == PAT_STRIDED){
+      cur = (cur + period - window) % words;
+    }
+  }
+
+  bool ok = binary ? writer.close() : (fclose(fp) == 0);
+  if (!ok){
+    if (!binary){
+      cerr << "Error writing " << traceFile << endl;
+    }
+    return 1;
+  }
+  cout << "Synthesized " << samples * window << " loads in " << samples
+       << " samples on " << ncpus << " CPUs into " << traceFile << endl;
+  return 0;
+}
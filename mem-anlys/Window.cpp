@@ -32,18 +32,18 @@
 #include <algorithm>
 //***************************************************************************
 #include "Window.hpp"
-#include "Address.hpp"
-#include "Instruction.hpp"
-#include "CPU.hpp"
 #include "metrics.hpp"
 //***************************************************************************
 using namespace std;
+
+    int Window::sketchPrecision = 0;
     
     Window::~Window() {
       delete trace;
+      delete sketch;
     }
     
-    Window::Window () {
+    Window::Window (TraceStore *_store) {
       left = NULL;
       right = NULL;
       parent = NULL;
@@ -55,7 +55,11 @@ using namespace std;
       multiplier =  1;
       //multiplierAvg = 1;//REMOVING_XTRA
       constant_lds = 0;
-      trace = new Trace();
+      trace = new Trace(_store);
+      sketch = NULL;
+      if (sketchPrecision > 0){
+        sketch = new FPSketch(sketchPrecision);
+      }
     }
     
     void Window::setStime( unsigned long _stime ) { stime = _stime;}
@@ -64,104 +68,62 @@ using namespace std;
     void Window::calcTime(){
     	int size = trace->trace.size();
 	int mid = size/2;
-	this->setStime(trace->trace[0]->time->time);
-	this->setMtime(trace->trace[mid]->time->time);
-	this->setEtime(trace->trace[size-1]->time->time);
+	this->setStime(trace->store->timeOf(trace->trace[0]));
+	this->setMtime(trace->store->timeOf(trace->trace[mid]));
+	this->setEtime(trace->store->timeOf(trace->trace[size-1]));
     }
     
     void Window::setID ( pair<unsigned long, uint32_t> _windowID ) { windowID = _windowID; } 
     
     unsigned long Window::calcConstantLds(){
       //unsigned long constant_lds = 0;
+      TraceStore *store = trace->store;
       for (auto it = trace->trace.begin(); it != trace->trace.end();  it++){
-        this->constant_lds += (*it)->ip->getExtraFrameLds();
+        this->constant_lds += store->extra_frame_lds[*it];
       }
       return this->constant_lds;
     }
      
-    void Window::addAccess(Access *add){
+    void Window::addAccess(uint32_t add){
       trace->addAccess(add);
-      map <unsigned long, map <enum Metrics, uint32_t>>::iterator it = fpMap.find(add->addr->addr);
-      if (it == fpMap.end()){
-        map <enum Metrics, uint32_t> addthis;
-        addthis.insert({add->ip->type, 1});
-        if (add->ip->getExtraFrameLds() >0){
-          addthis.insert({CONSTANT,add->ip->getExtraFrameLds()});
-        }
-        fpMap.insert({add->addr->addr , addthis});
-      } else {
-        map <enum Metrics, uint32_t>::iterator tit = it->second.find(add->ip->type);
-        if (tit != it->second.end()){
-          tit->second++;
-        } else {
-          it->second.insert({add->ip->type, 1});
+      TraceStore *store = trace->store;
+      unsigned long addr = store->addr[add];
+      enum Metrics type = store->type[add];
+      uint16_t extra_frame_lds = store->extra_frame_lds[add];
+      if (sketch != NULL){
+        sketch->add(addr, type);
+        if (extra_frame_lds >0){
+          sketch->add(addr, CONSTANT);
         }
-        if (add->ip->getExtraFrameLds() >0){
-          tit = it->second.find(CONSTANT);
-          if (tit != it->second.end()){
-            tit->second+=add->ip->getExtraFrameLds();
-          } else {
-            it->second.insert({CONSTANT,add->ip->getExtraFrameLds()});
-          }
-        }
-
+        return;
+      }
+      FPTable::Entry &e = fpMap.get(addr);
+      e.count[FPTable::classOf(type)]++;
+      if (extra_frame_lds >0){
+        e.count[FPTable::classOf(CONSTANT)] += extra_frame_lds;
       }
     }
     
     
     void Window::addWindow(Window * w){
       this->period = w->period;
+      TraceStore *store = w->trace->store;
+      if (sketch != NULL){
+        if (w->sketch != NULL){
+          sketch->merge(*w->sketch);
+        }
+        return;
+      }
       if (this->fpMap.empty()){
+        fpMap.reserve(this->trace->getSize() + w->trace->getSize());
         for (auto ait=this->trace->trace.begin(); ait != this->trace->trace.end(); ait++){
-          map <unsigned long, map <enum Metrics, uint32_t>>::iterator it = this->fpMap.find((*ait)->addr->addr);
-          if (it == fpMap.end()){
-            map <enum Metrics, uint32_t> addthis;
-            addthis.insert({(*ait)->ip->type, 1});
-            fpMap.insert({(*ait)->addr->addr , addthis});
-          } else {
-            map <enum Metrics, uint32_t>::iterator tit = it->second.find((*ait)->ip->type);
-            if (tit != it->second.end()){
-              tit->second++;
-            } else {
-              it->second.insert({(*ait)->ip->type, 1});
-            }
-
-          }
+          fpMap.add(store->addr[*ait], store->type[*ait]);
         }
         for (auto ait=w->trace->trace.begin(); ait != w->trace->trace.end(); ait++){
-          map <unsigned long, map <enum Metrics, uint32_t>>::iterator it = this->fpMap.find((*ait)->addr->addr);
-          if (it == fpMap.end()){
-            map <enum Metrics, uint32_t> addthis;
-            addthis.insert({(*ait)->ip->type, 1});
-            fpMap.insert({(*ait)->addr->addr , addthis});
-          } else {
-            map <enum Metrics, uint32_t>::iterator tit = it->second.find((*ait)->ip->type);
-            if (tit != it->second.end()){
-              tit->second++;
-            } else {
-              it->second.insert({(*ait)->ip->type, 1});
-            }
-
-          }
+          fpMap.add(store->addr[*ait], store->type[*ait]);
         }
       } else {
-        map <unsigned long, map <enum Metrics, uint32_t>>::iterator it = w->fpMap.begin();
-        for ( ; it != w->fpMap.end(); it++){
-          map <unsigned long, map <enum Metrics, uint32_t>>::iterator curr_it = this->fpMap.find(it->first);
-          if (curr_it == this->fpMap.end()){
-            fpMap.insert({it->first, it->second});
-          } else {
-            map <enum Metrics, uint32_t>::iterator tit = it->second.begin();
-            for (; tit != it->second.end(); tit++){
-              map <enum Metrics, uint32_t>::iterator curr_tit = curr_it->second.find(tit->first);
-              if (curr_tit != curr_it->second.end()){
-                curr_tit->second+=tit->second;
-              } else {
-                curr_it->second.insert({tit->first, tit->second});
-              }
-            }
-          }
-        }
+        fpMap.merge(w->fpMap);
       } 
     }
     
@@ -169,21 +131,24 @@ using namespace std;
     int Window::getFP(){return fpMetrics[FP];}
 
 
-    void Window::getdiagMap (map <enum Metrics,uint32_t> *typeMap) {
-      map <enum Metrics, uint32_t>::iterator tit = typeMap->begin();
+    void Window::getdiagMap (FPTable::Entry *typeMap) {
       map <enum Metrics, double>::iterator did;
       double total = 0;
       double freq = 1.0; 
-      for (;  tit != typeMap->end(); tit++){
-        total +=tit->second;
+      for (int c = 0; c < FPT_NCLASS; c++){
+        total +=typeMap->count[c];
       }
-      for (tit = typeMap->begin();  tit != typeMap->end(); tit++){
-        freq =  ( (double)tit->second / (double)total);
-        did =  fpMetrics.find(tit->first);
+      for (int c = 0; c < FPT_NCLASS; c++){
+        if (typeMap->count[c] == 0){
+          continue;
+        }
+        enum Metrics type = FPTable::typeOf(c);
+        freq =  ( (double)typeMap->count[c] / (double)total);
+        did =  fpMetrics.find(type);
         if (did !=  fpMetrics.end()){
           did->second += freq;
         } else { 
-          fpMetrics.insert({tit->first, freq});
+          fpMetrics.insert({type, freq});
         }
       }
     }
@@ -194,19 +159,33 @@ using namespace std;
       diagMap = &fpMetrics;
     }
     void  Window::calcFPMetrics(){
-      map <unsigned long, map <enum Metrics,uint32_t>>::iterator fp_it = this->fpMap.begin();
+      if (sketch != NULL){
+        // distinct addresses per class instead of per-address type shares
+        fpMetrics[FP] = floor(sketch->estimate() + 0.5);
+        fpMetrics[WINDOW_SIZE] = this->getSize();
+        fpMetrics[STRIDED] = floor(sketch->estimate(FPSketch::SK_STRIDED) + 0.5);
+        fpMetrics[INDIRECT] = floor(sketch->estimate(FPSketch::SK_INDIRECT) + 0.5);
+        fpMetrics[CONSTANT] = floor(sketch->estimate(FPSketch::SK_CONSTANT) + 0.5);
+        fpMetrics[UNKNOWN] = floor(sketch->estimate(FPSketch::SK_UNKNOWN) + 0.5);
+        return;
+      }
+      FPTable::iterator fp_it = this->fpMap.begin();
       fpMetrics[FP]= fpMap.size();
       fpMetrics[WINDOW_SIZE] = this->getSize();
       for (; fp_it != this->fpMap.end() ;  fp_it++){
-        if (fp_it->second.size() ==1){
-          map <enum Metrics, double >::iterator dmit =  fpMetrics.find(fp_it->second.begin()->first);
+        if (FPTable::numTypes(*fp_it) ==1){
+          int c = 0;
+          while (fp_it->count[c] == 0){
+            c++;
+          }
+          map <enum Metrics, double >::iterator dmit =  fpMetrics.find(FPTable::typeOf(c));
           if (dmit != fpMetrics.end()){
             dmit->second++;
           } else {
-            fpMetrics.insert({fp_it->second.begin()->first, 1.0});
+            fpMetrics.insert({FPTable::typeOf(c), 1.0});
           }
         } else { 
-          getdiagMap(&(fp_it->second));    
+          getdiagMap(&(*fp_it));    
         }
       } 
     }
@@ -309,19 +288,20 @@ using namespace std;
       uint32_t prev_sampleID = 0;
       int total_loads_in_trace = 0;
       int total_loads_in_window = 0;
+      TraceStore *store = trace->store;
 
       for(auto it = trace->trace.begin(); it != trace->trace.end(); it++) {
-        total_loads_in_window = total_loads_in_window + 1 + (*it)->ip->getExtraFrameLds();
-        total_loads_in_trace = total_loads_in_trace + 1 + (*it)->ip->getExtraFrameLds();
+        total_loads_in_window = total_loads_in_window + 1 + store->extra_frame_lds[*it];
+        total_loads_in_trace = total_loads_in_trace + 1 + store->extra_frame_lds[*it];
         current_ws++;
         if (is_first){
           is_first = false;
-          window_first_time = (*it)->time->time;
-          prevTime = (*it)->time->time;
-          prev_sampleID = (*it)->time->getSampleID();
+          window_first_time = store->timeOf(*it);
+          prevTime = store->timeOf(*it);
+          prev_sampleID = store->sampleID[*it];
         }
 //Dividing trace regarding the sampling frequency/period
-          if (prev_sampleID != (*it)->time->getSampleID()){
+          if (prev_sampleID != store->sampleID[*it]){
             new_sample = true;
           } else {
             new_sample = false;
@@ -332,9 +312,9 @@ using namespace std;
           number_of_windows++;
           window_size+=current_ws;
           wSize.push_back(current_ws);
-          skip_time+=((*it)->time->time - prevTime);
-          Zt.push_back((*it)->time->time - prevTime);
-          current_ztime = ((*it)->time->time - prevTime);
+          skip_time+=(store->timeOf(*it) - prevTime);
+          Zt.push_back(store->timeOf(*it) - prevTime);
+          current_ztime = (store->timeOf(*it) - prevTime);
           unsigned long z_curr;
           if (prevTime - window_first_time){
             z_curr = (current_ws*current_ztime)/(prevTime - window_first_time);
@@ -344,12 +324,12 @@ using namespace std;
           Zs.push_back(z_curr);
           window_time += prevTime - window_first_time;
           wTime.push_back(prevTime - window_first_time);
-          window_first_time =  (*it)->time->time;
+          window_first_time =  store->timeOf(*it);
           wMultipliers.push_back((float)period/(float)total_loads_in_window);
           current_ws = 1;
         }
-        prevTime = (*it)->time->time;
-        prev_sampleID = (*it)->time->getSampleID();
+        prevTime = store->timeOf(*it);
+        prev_sampleID = store->sampleID[*it];
       }
 
       //calculating LoadBased Multiplier versions:
@@ -443,11 +423,26 @@ using namespace std;
     }
 
     void Window::removeFPMap(){
-      map <unsigned long, map <enum Metrics, uint32_t>>::iterator it = fpMap.begin();
-      while(it != fpMap.end()){
-        it->second.clear();
-        it++;
-      }
       fpMap.clear();
+      delete sketch;
+      sketch = NULL;
+    }
+
+    // Number of distinct addresses (estimated with sketches)
+    double Window::getFPSize(){
+      if (sketch != NULL){
+        return floor(sketch->estimate() + 0.5);
+      }
+      return fpMap.size();
+    }
+
+    bool Window::hasFP(){
+      return sketch != NULL || !fpMap.empty();
+    }
+
+    // Takes over the footprint of w
+    void Window::moveFP(Window *w){
+      fpMap.swap(w->fpMap);
+      std::swap(sketch, w->sketch);
     }
 
@@ -42,6 +42,8 @@
 //class Access;
 
 #include "Trace.hpp"
+#include "FPSketch.hpp"
+#include "FPTable.hpp"
 //#include "AccessTime.hpp"
 
 //***************************************************************************
@@ -68,9 +70,11 @@ class Window {
     Trace *trace;
     pair<unsigned long, uint32_t> windowID;
     map <enum Metrics, double> fpMetrics;
-    map <unsigned long, map <enum Metrics, uint32_t>> fpMap; //<address < type, count> 
-    
-    Window ();
+    FPTable fpMap; //<address < type, count> 
+    FPSketch *sketch; // replaces fpMap when sketchPrecision > 0
+    static int sketchPrecision; // 0: exact footprint
+
+    Window (TraceStore *_store);
     ~Window ();
 //OZGURCLEANUP DEPRICATE ??    void setFuncName( std::string _name );
 //OZGURCLEANUP DEPRICATE ??    void setFuncName();
@@ -86,7 +90,7 @@ class Window {
     void calcTime();
     void setID ( pair<unsigned long, uint32_t> _windowID ); 
 //OZGURCLEANUP    void addAddress(Address *add);
-    void addAccess(Access *access);
+    void addAccess(uint32_t access);
     void addWindow(Window * w);
     pair<unsigned long, uint32_t> getWindowID ();
     int getFP();
@@ -101,7 +105,7 @@ class Window {
     void addRightChild (Window *w);
     void addLeftChild (Window *w);
     //void getdiagMap (map <enum Metrics,uint32_t> *typeMap, map <enum Metrics, double> *fpDiagMap);  
-    void getdiagMap (map <enum Metrics,uint32_t> *typeMap);  
+    void getdiagMap (FPTable::Entry *typeMap);  
     void  getFPDiag(map <enum Metrics, double> *diagMap);
     void  calcFPMetrics();
     float calcMultiplier();
@@ -109,6 +113,25 @@ class Window {
     map<enum Metrics, double> getMetrics();
     map<enum Metrics, double> calculateMetrics();
     void removeFPMap();
+    double getFPSize();
+    bool hasFP();
+    void moveFP(Window *w);
+
+    // Footprint only (fpMap or sketch), for the incremental state
+    // (Archive: CacheFile)
+    template <class Archive>
+    void serializeFP(Archive &ar){
+      bool hasSketch = (sketch != NULL);
+      ar.item(hasSketch);
+      if (ar.isReading()){
+        delete sketch;
+        sketch = hasSketch ? new FPSketch(sketchPrecision) : NULL;
+      }
+      ar.item(fpMap);
+      if (hasSketch){
+        ar.item(*sketch);
+      }
+    }
 };
 
 #endif
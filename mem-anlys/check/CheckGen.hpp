@@ -0,0 +1,52 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// Random access streams of the check programs
+//***************************************************************************
+#ifndef CHECKGEN_H
+#define CHECKGEN_H
+
+#include <stdint.h>
+#include <random>
+//***************************************************************************
+using namespace std;
+
+// Keys in [0, numKeys); hotPct% of them go to the first 1/hotFrac of the
+// keys (at least one key)
+class HotColdGen {
+public:
+  HotColdGen(uint32_t numKeys, uint32_t hotFrac, int hotPct, uint64_t seed)
+    : rng(seed), anyKey(0, numKeys - 1), hotKey(0, (numKeys + hotFrac - 1) / hotFrac - 1), percent(0, 99){
+    pct = hotPct;
+  }
+
+  uint32_t next(){
+    return (percent(rng) < pct) ? hotKey(rng) : anyKey(rng);
+  }
+
+  // Uniform in [lo, hi], from the same stream as the keys
+  uint32_t between(uint32_t lo, uint32_t hi){
+    return uniform_int_distribution<uint32_t>(lo, hi)(rng);
+  }
+
+private:
+  mt19937_64 rng;
+  uniform_int_distribution<uint32_t> anyKey, hotKey;
+  uniform_int_distribution<int> percent;
+  int pct;
+};
+
+#endif
@@ -0,0 +1,162 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// fptable-bench: insert and merge throughput of the footprint table
+// (FPTable) against the former map <address, map <type, count>>.
+//
+//   fptable-bench [accesses] [distinct addresses]
+//***************************************************************************
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <vector>
+//***************************************************************************
+#include "../FPTable.hpp"
+#include "../metrics.hpp"
+//***************************************************************************
+using namespace std;
+
+typedef map <unsigned long, map <enum Metrics, uint32_t>> FPMap;
+
+static void mapAdd(FPMap &fpMap, unsigned long addr, enum Metrics type, uint32_t n = 1){
+  FPMap::iterator it = fpMap.find(addr);
+  if (it == fpMap.end()){
+    map <enum Metrics, uint32_t> addthis;
+    addthis.insert({type, n});
+    fpMap.insert({addr, addthis});
+  } else {
+    map <enum Metrics, uint32_t>::iterator tit = it->second.find(type);
+    if (tit != it->second.end()){
+      tit->second += n;
+    } else {
+      it->second.insert({type, n});
+    }
+  }
+}
+
+// Same merge as the former Window::addWindow
+static void mapMerge(FPMap &fpMap, FPMap &w){
+  for (FPMap::iterator it = w.begin(); it != w.end(); it++){
+    FPMap::iterator curr_it = fpMap.find(it->first);
+    if (curr_it == fpMap.end()){
+      fpMap.insert({it->first, it->second});
+    } else {
+      for (auto tit = it->second.begin(); tit != it->second.end(); tit++){
+        auto curr_tit = curr_it->second.find(tit->first);
+        if (curr_tit != curr_it->second.end()){
+          curr_tit->second += tit->second;
+        } else {
+          curr_it->second.insert({tit->first, tit->second});
+        }
+      }
+    }
+  }
+}
+
+static double seconds(chrono::steady_clock::time_point t0){
+  return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[]) {
+  unsigned long naccess = (argc > 1) ? strtoul(argv[1], NULL, 10) : 4000000;
+  unsigned long ndistinct = (argc > 2) ? strtoul(argv[2], NULL, 10) : 500000;
+  const enum Metrics types[4] = {UNKNOWN, CONSTANT, STRIDED, INDIRECT};
+
+  // 8-byte aligned addresses; type is a function of the address with an
+  // occasional second type, as in a load-classified trace
+  mt19937_64 rng(42);
+  vector <unsigned long> addrs(naccess);
+  vector <enum Metrics> tys(naccess);
+  for (unsigned long i = 0; i < naccess; i++){
+    unsigned long a = rng() % ndistinct;
+    addrs[i] = 0x7f0000000000UL + a * 8;
+    tys[i] = types[(a + ((rng() & 15) == 0)) & 3];
+  }
+
+  cout << "accesses: " << naccess << " distinct addresses: " << ndistinct << endl;
+  cout << left << setw(10) << "op" << setw(14) << "map(Macc/s)" << setw(16) << "FPTable(Macc/s)"
+       << "speedup" << endl;
+
+  // Insert: one table from the whole access stream
+  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+  FPMap m;
+  for (unsigned long i = 0; i < naccess; i++){
+    mapAdd(m, addrs[i], tys[i]);
+  }
+  double tMap = seconds(t0);
+
+  t0 = chrono::steady_clock::now();
+  FPTable t;
+  for (unsigned long i = 0; i < naccess; i++){
+    t.add(addrs[i], tys[i]);
+  }
+  double tTable = seconds(t0);
+  if (m.size() != t.size()){
+    cerr << "Error: footprint mismatch " << m.size() << " != " << t.size() << endl;
+    return 1;
+  }
+  cout << left << setw(10) << "insert" << setw(14) << naccess / tMap / 1e6
+       << setw(16) << naccess / tTable / 1e6 << tMap / tTable << endl;
+
+  // Merge: binary tree of leaves of 8 accesses, as buildTree does
+  const unsigned long leaf = 8;
+  vector <FPMap> mLevel;
+  vector <FPTable> tLevel;
+  for (unsigned long i = 0; i < naccess; i += leaf){
+    mLevel.push_back(FPMap());
+    tLevel.push_back(FPTable());
+    for (unsigned long j = i; j < i + leaf && j < naccess; j++){
+      mapAdd(mLevel.back(), addrs[j], tys[j]);
+      tLevel.back().add(addrs[j], tys[j]);
+    }
+  }
+  t0 = chrono::steady_clock::now();
+  while (mLevel.size() > 1){
+    vector <FPMap> next((mLevel.size() + 1) / 2);
+    for (size_t i = 0; i < mLevel.size(); i += 2){
+      next[i / 2].swap(mLevel[i]);
+      if (i + 1 < mLevel.size()){
+        mapMerge(next[i / 2], mLevel[i + 1]);
+      }
+    }
+    mLevel.swap(next);
+  }
+  tMap = seconds(t0);
+
+  t0 = chrono::steady_clock::now();
+  while (tLevel.size() > 1){
+    vector <FPTable> next((tLevel.size() + 1) / 2);
+    for (size_t i = 0; i < tLevel.size(); i += 2){
+      next[i / 2].swap(tLevel[i]);
+      if (i + 1 < tLevel.size()){
+        next[i / 2].merge(tLevel[i + 1]);
+      }
+    }
+    tLevel.swap(next);
+  }
+  tTable = seconds(t0);
+  if (mLevel[0].size() != tLevel[0].size()){
+    cerr << "Error: merged footprint mismatch " << mLevel[0].size() << " != " << tLevel[0].size() << endl;
+    return 1;
+  }
+  cout << left << setw(10) << "merge" << setw(14) << naccess / tMap / 1e6
+       << setw(16) << naccess / tTable / 1e6 << tMap / tTable << endl;
+  return 0;
+}
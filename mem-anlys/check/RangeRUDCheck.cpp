@@ -0,0 +1,140 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// range-rud-check: RUD of a zoom node of memgaze-analyze-loc from the trace
+// lines of its range (getRangeRUD, AddrIndex) against spatialAnalysis over
+// the whole trace. Access count, lifetime and in-sample RUD of every block
+// must be identical; prints one line per case, 'mismatch' on any
+// difference.
+//***************************************************************************
+
+#include <stdint.h>
+#include <math.h>
+#include <iostream>
+#include <random>
+#include <vector>
+//***************************************************************************
+#include "../loc-anlys/src/memoryanalysis.h"
+//***************************************************************************
+using namespace std;
+
+extern int printProgress;
+
+static const uint64_t traceBase = 0x7f0000000000UL;
+
+// Samples of 1 to maxSampleLen lines; hotPct% of the loads in the first
+// 1/16 of span bytes
+static void makeTrace(vector<TraceLine *>& trace, uint32_t numLines, uint32_t maxSampleLen,
+                      uint64_t span, int hotPct, uint64_t seed){
+  mt19937_64 rng(seed);
+  uniform_int_distribution<uint32_t> sampleLen(1, maxSampleLen);
+  uniform_int_distribution<uint64_t> anyAddr(0, span - 1);
+  uniform_int_distribution<uint64_t> hotAddr(0, span / 16);
+  uniform_int_distribution<int> percent(0, 99);
+  uint32_t sampleId = 1, left = sampleLen(rng);
+  for (uint32_t l = 0; l < numLines; l++){
+    if (left == 0){
+      sampleId++;
+      left = sampleLen(rng);
+    }
+    left--;
+    uint64_t addr = traceBase + ((percent(rng) < hotPct) ? hotAddr(rng) : anyAddr(rng));
+    trace.push_back(new TraceLine(0x401000 + l % 64, addr, 0, 0, sampleId));
+  }
+}
+
+static vector<BlockInfo *> makeBlocks(MemArea memarea){
+  vector<BlockInfo *> blocks;
+  for (uint32_t i = 0; i < memarea.blockCount; i++){
+    blocks.push_back(new BlockInfo(make_pair(0, i), memarea.min + i * memarea.blockSize,
+                                   memarea.min + (i + 1) * memarea.blockSize - 1, memarea.blockCount, 0, "chk"));
+  }
+  return blocks;
+}
+
+// Random ranges of up to maxBlocks blocks
+static bool runCase(int id, vector<TraceLine *>& trace, AddrIndex& addrIndex, uint64_t span,
+                    int numRanges, uint32_t maxBlocks, uint64_t seed){
+  mt19937_64 rng(seed);
+  uniform_int_distribution<uint64_t> anyAddr(0, span - 1);
+  uniform_int_distribution<uint32_t> numBlocks(1, maxBlocks);
+  vector<pair<uint64_t, uint64_t>> noRegions;
+  vector<uint64_t> noLines;
+  MemArea memInclude;
+  memInclude.blockCount = 1;
+  uint64_t accesses = 0;
+  for (int r = 0; r < numRanges; r++){
+    uint64_t lo = anyAddr(rng), hi = anyAddr(rng);
+    MemArea memarea;
+    memarea.min = traceBase + min(lo, hi);
+    memarea.max = traceBase + max(lo, hi);
+    if (r == 0){
+      memarea.min = traceBase;
+      memarea.max = traceBase + span - 1;
+    }
+    memarea.blockCount = numBlocks(rng);
+    memarea.blockSize = ceil((memarea.max - memarea.min) / (double)memarea.blockCount);
+    if (memarea.blockSize == 0){
+      memarea.blockSize = 1;
+      memarea.blockCount = 1;
+    }
+    vector<BlockInfo *> whole = makeBlocks(memarea), range = makeBlocks(memarea);
+    spatialAnalysis(trace, memarea, 0, 0, whole, noRegions, memInclude, noRegions, noLines, 1);
+    getRangeRUD(addrIndex, memarea, range);
+    for (uint32_t i = 0; i < memarea.blockCount; i++){
+      if (whole[i]->getTotalAccess() != range[i]->getTotalAccess() ||
+          whole[i]->getLifetime() != range[i]->getLifetime() ||
+          whole[i]->getTotalRUD() != range[i]->getTotalRUD() ||
+          whole[i]->getSampleAvgRUD() != range[i]->getSampleAvgRUD()){
+        cout << "case " << id << " mismatch: range " << hex << memarea.min << "-" << memarea.max << dec
+             << " block " << i << " access " << range[i]->getTotalAccess() << " expected " << whole[i]->getTotalAccess()
+             << " lifetime " << range[i]->getLifetime() << " expected " << whole[i]->getLifetime()
+             << " sampleAvgRUD " << range[i]->getSampleAvgRUD() << " expected " << whole[i]->getSampleAvgRUD() << endl;
+        return false;
+      }
+      accesses += range[i]->getTotalAccess();
+    }
+    for (uint32_t i = 0; i < memarea.blockCount; i++){
+      delete whole[i];
+      delete range[i];
+    }
+  }
+  cout << "case " << id << " lines " << trace.size() << " ranges " << numRanges
+       << " accesses " << accesses << " identical" << endl;
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  printProgress = 0;
+  bool ok = true;
+  struct { uint32_t numLines, maxSampleLen; uint64_t span; int hotPct; uint32_t maxBlocks; } cases[] = {
+    {1, 1, 64, 0, 1},
+    {2000, 1, 4096, 0, 8},        // one line per sample
+    {20000, 64, 1 << 20, 50, 16},
+    {100000, 512, 1 << 16, 90, 256},
+    {100000, 4096, 1 << 24, 20, 64}
+  };
+  for (int c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); c++){
+    vector<TraceLine *> trace;
+    makeTrace(trace, cases[c].numLines, cases[c].maxSampleLen, cases[c].span, cases[c].hotPct, c + 1);
+    AddrIndex addrIndex(trace, 2);
+    ok = runCase(c + 1, trace, addrIndex, cases[c].span, 20, cases[c].maxBlocks, c + 1) && ok;
+    for (size_t l = 0; l < trace.size(); l++){
+      delete trace[l];
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// report-check: round trip of the memgaze-analyze report outputs.
+//   report-check <-ob file> <-oc prefix> <-o file>
+// The binary report is read back; prints the schema of every table, which
+// must write the same CSV as -oc, and the levels table must render as the
+// first table of the -o text. Prints 'mismatch' on any difference.
+//***************************************************************************
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+//***************************************************************************
+#include "../Report.hpp"
+//***************************************************************************
+using namespace std;
+
+static string readFile(string path){
+  ifstream in(path, ios::binary);
+  return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+static const char * typeName(ReportType type){
+  switch (type){
+    case REPORT_INT:
+      return "int";
+    case REPORT_DOUBLE:
+      return "double";
+    default:
+      return "string";
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 4){
+    cerr << "Usage: report-check <-ob file> <-oc prefix> <-o file>" << endl;
+    return 1;
+  }
+  string binFile = argv[1], csvPrefix = argv[2], textFile = argv[3];
+  Report report;
+  if (!report.readBinary(binFile)){
+    cout << "mismatch: cannot read " << binFile << endl;
+    return 1;
+  }
+  string rtPrefix = csvPrefix + ".rt";
+  report.writeCSV(rtPrefix);
+
+  bool ok = true;
+  for (auto it = report.tables.begin(); it != report.tables.end(); it++){
+    cout << "table " << it->name << " rows " << it->getNumRows() << endl;
+    for (size_t c = 0; c < it->columns.size(); c++){
+      cout << "  " << it->columns[c].name << " " << typeName(it->columns[c].type) << endl;
+    }
+    string csv = readFile(csvPrefix + "." + it->name + ".csv");
+    bool same = !csv.empty() && csv == readFile(rtPrefix + "." + it->name + ".csv");
+    cout << "  csv " << (same ? "identical" : "mismatch") << endl;
+    ok = ok && same;
+    remove((rtPrefix + "." + it->name + ".csv").c_str());
+
+    if (it->name == "levels"){
+      // -o starts with the levels table, up to the first empty line
+      string text = readFile(textFile);
+      size_t end = text.find("\n\n");
+      text = text.substr(0, (end == string::npos) ? text.size() : end + 1);
+      ostringstream levels;
+      it->printText(levels, 16);
+      same = !text.empty() && levels.str() == text;
+      cout << "  text " << (same ? "identical" : "mismatch") << endl;
+      ok = ok && same;
+    }
+  }
+  return ok ? 0 : 1;
+}
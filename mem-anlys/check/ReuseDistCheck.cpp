@@ -0,0 +1,106 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// reuse-dist-check: reuse distance of memgaze-analyze -R (ReuseTracker)
+// against a brute-force LRU stack. Streams are split in segments that
+// restart the tracker as samples do; segments larger than a node pool chunk
+// make the restarted tracker reuse the pool. Every access must be cold or
+// at the same distance in both; prints one line per case, 'mismatch' on any
+// difference.
+//***************************************************************************
+
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+//***************************************************************************
+#include "../ReuseDist.hpp"
+#include "CheckGen.hpp"
+//***************************************************************************
+using namespace std;
+
+// Addresses from the most to the least recent: the distance of an access is
+// the number of addresses above it
+class StackReuse {
+public:
+  bool access(unsigned long addr, unsigned long *dist){
+    for (size_t j = stack.size(); j > 0; j--){
+      if (stack[j - 1] == addr){
+        *dist = stack.size() - j;
+        stack.erase(stack.begin() + (j - 1));
+        stack.push_back(addr);
+        return true;
+      }
+    }
+    stack.push_back(addr);
+    return false;
+  }
+
+  void clear(){ stack.clear();}
+
+private:
+  vector<unsigned long> stack;
+};
+
+// Segments of sweep cold touches over the first sweep addresses, followed
+// by reuses random addresses of numAddrs; hotPct% of the random accesses go
+// to the first 1/16 of the addresses
+static bool runCase(int id, uint32_t numAddrs, uint32_t segments, uint32_t sweep, uint32_t reuses,
+                    int hotPct, uint64_t seed){
+  HotColdGen gen(numAddrs, 16, hotPct, seed);
+  ReuseTracker tracker;
+  StackReuse stack;
+  uint64_t accesses = 0, cold = 0;
+  for (uint32_t s = 0; s < segments; s++){
+    if (s > 0){
+      tracker.clear();
+      stack.clear();
+    }
+    for (uint32_t a = 0; a < sweep + reuses; a++){
+      uint32_t k = (a < sweep) ? a : gen.next();
+      unsigned long addr = 0x7f0000000000UL + (unsigned long)k * 64;
+      unsigned long dist = 0, expDist = 0;
+      bool reused = tracker.access(addr, &dist);
+      bool expReused = stack.access(addr, &expDist);
+      if (reused != expReused || (reused && dist != expDist)){
+        cout << "case " << id << " mismatch: segment " << s << " access " << a << " distance "
+             << (reused ? to_string(dist) : "cold") << " expected " << (expReused ? to_string(expDist) : "cold") << endl;
+        return false;
+      }
+      accesses++;
+      cold += !reused;
+    }
+  }
+  cout << "case " << id << " addresses " << numAddrs << " segments " << segments
+       << " accesses " << accesses << " cold " << cold << " identical" << endl;
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  bool ok = true;
+  struct { uint32_t numAddrs, segments, sweep, reuses; int hotPct; } cases[] = {
+    {1, 1, 0, 100, 0},
+    {64, 1, 0, 20000, 0},
+    {512, 200, 0, 300, 50},
+    {4096, 20, 64, 5000, 90},
+    {40000, 4, 40000, 4000, 50},  // segments of 40000 nodes span two pool chunks
+    {40000, 6, 40000, 0, 0}
+  };
+  for (int c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); c++){
+    ok = runCase(c + 1, cases[c].numAddrs, cases[c].segments, cases[c].sweep, cases[c].reuses,
+                 cases[c].hotPct, c + 1) && ok;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// sample-rud-check: intra-sample reuse distance of memgaze-analyze-loc
+// (SampleRUD) against the former LRU stack search of spatialAnalysis.
+// Every access distance and the resulting per-block inSampleAvgRUD must be
+// identical; prints one line per case, 'mismatch' on any difference.
+//***************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+//***************************************************************************
+#include "../loc-anlys/src/SampleRUD.hpp"
+#include "CheckGen.hpp"
+//***************************************************************************
+using namespace std;
+
+// Former spatialAnalysis: search the block in the sample stack and move it
+// to the top
+class StackRUD {
+public:
+  StackRUD(uint32_t numBlocks){
+    stack.assign(numBlocks, 0);
+    inSample.assign(numBlocks, 0);
+    length = 0;
+  }
+
+  int access(uint32_t blockID){
+    inSample[blockID]++;
+    if (inSample[blockID] == 1){
+      stack[length] = blockID;
+      length++;
+      return -1;
+    }
+    uint32_t pos = 0;
+    for (uint32_t j = 0; j < length; ++j){
+      if (stack[j] == blockID){
+        pos = j;
+        break;
+      }
+    }
+    int dist = length - pos - 1;
+    for (uint32_t j = pos; j < length - 1; ++j){
+      stack[j] = stack[j + 1];
+    }
+    stack[length - 1] = blockID;
+    return dist;
+  }
+
+  void newSample(){
+    inSample.assign(inSample.size(), 0);
+    length = 0;
+  }
+
+private:
+  vector<uint32_t> stack;
+  vector<uint32_t> inSample;
+  uint32_t length;
+};
+
+// inSampleAvgRUD as spatialAnalysis computes it from the access distances
+class AvgRUD {
+public:
+  vector<double> avg;
+
+  AvgRUD(uint32_t numBlocks){
+    avg.assign(numBlocks, -1);
+    access.assign(numBlocks, 0);
+    total.assign(numBlocks, 0);
+    cnt.assign(numBlocks, 0);
+  }
+
+  void add(uint32_t blockID, int dist){
+    access[blockID]++;
+    if (access[blockID] > 1){
+      total[blockID] += dist;
+    }
+  }
+
+  void endSample(){
+    for (uint32_t i = 0; i < avg.size(); i++){
+      if (access[i] > 1){
+        if (avg[i] == -1)
+          avg[i] = 0;
+        cnt[i]++;
+        avg[i] = ((avg[i] * (cnt[i] - 1)) + (double)total[i] / (double)(access[i] - 1)) / cnt[i];
+      }
+      total[i] = 0;
+      access[i] = 0;
+    }
+  }
+
+private:
+  vector<uint32_t> access, total, cnt;
+};
+
+// Samples of random lengths in [1, maxLen]; hotPct% of the accesses go
+// to the first 1/8 of the blocks
+static bool runCase(int id, uint32_t numBlocks, uint32_t samples, uint32_t maxLen, int hotPct, uint64_t seed){
+  HotColdGen gen(numBlocks, 8, hotPct, seed);
+  vector<vector<uint32_t>> trace(samples);
+  for (uint32_t s = 0; s < samples; s++){
+    trace[s].resize(gen.between(1, maxLen));
+    for (uint32_t a = 0; a < trace[s].size(); a++){
+      trace[s][a] = gen.next();
+    }
+  }
+
+  StackRUD stackRUD(numBlocks);
+  SampleRUD sampleRUD(numBlocks, maxLen);
+  AvgRUD stackAvg(numBlocks), sampleAvg(numBlocks);
+  uint64_t accesses = 0;
+  for (uint32_t s = 0; s < samples; s++){
+    for (uint32_t a = 0; a < trace[s].size(); a++){
+      uint32_t b = trace[s][a];
+      int d0 = stackRUD.access(b);
+      int d1 = sampleRUD.access(b);
+      if (d0 != d1){
+        cout << "case " << id << " mismatch: sample " << s << " access " << a << " block " << b
+             << " distance " << d1 << " expected " << d0 << endl;
+        return false;
+      }
+      stackAvg.add(b, d0);
+      sampleAvg.add(b, d1);
+      accesses++;
+    }
+    stackRUD.newSample();
+    sampleRUD.newSample();
+    stackAvg.endSample();
+    sampleAvg.endSample();
+  }
+  if (memcmp(stackAvg.avg.data(), sampleAvg.avg.data(), numBlocks * sizeof(double)) != 0){
+    cout << "case " << id << " mismatch: inSampleAvgRUD" << endl;
+    return false;
+  }
+  cout << "case " << id << " blocks " << numBlocks << " samples " << samples
+       << " accesses " << accesses << " identical" << endl;
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  bool ok = true;
+  struct { uint32_t numBlocks, samples, maxLen; int hotPct; } cases[] = {
+    {1, 50, 20, 0},
+    {16, 200, 600, 0},
+    {256, 200, 600, 50},
+    {320, 100, 2000, 90},
+    {4096, 50, 8192, 0},
+    {4096, 500, 1, 0}     // one access per sample
+  };
+  for (int c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); c++){
+    ok = runCase(c + 1, cases[c].numBlocks, cases[c].samples, cases[c].maxLen, cases[c].hotPct, c + 1) && ok;
+  }
+  return ok ? 0 : 1;
+}
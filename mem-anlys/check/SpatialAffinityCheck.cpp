@@ -0,0 +1,237 @@
+// -*-Mode: C++;-*-
+
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Ozgur Ozan Kilic, Nathan Tallent
+//***************************************************************************
+
+//***************************************************************************
+// spatial-affinity-check: spatial affinity of memgaze-analyze-loc
+// (SpatialAffinity) against the former accumulation of spatialAnalysis over
+// all blocks. The pairs of every reference block and all their values must
+// be identical; prints one line per case, 'mismatch' on any difference.
+//***************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <map>
+#include <vector>
+//***************************************************************************
+#include "../loc-anlys/src/SpatialAffinity.hpp"
+#include "CheckGen.hpp"
+//***************************************************************************
+using namespace std;
+
+// Former spatialAnalysis: per access, flush the middle counts of all blocks
+// and add the distance from all reference blocks of the sample
+class MapAffinity {
+public:
+  MapAffinity(uint32_t numRefBlocks, uint32_t numBlocks){
+    numRef = numRefBlocks;
+    numBlk = numBlocks;
+    totalAccess.assign(numBlocks, 0);
+    sampleLast.assign(numBlocks, 0);
+    lastPage = 0;
+  }
+
+  void access(uint32_t pageID, uint32_t time, bool newSample){
+    totalAccess[pageID]++;
+    if (!newSample && lastPage < numRef){
+      getPair(lastPage, pageID)->spatialNext++;
+    }
+    lastPage = pageID;
+    if (!newSample){
+      if (pageID < numRef){
+        for (uint32_t j = 0; j < numBlk; j++){
+          if (totalAccess[j] != 0){
+            SpatialRUD *cur = getPair(pageID, j);
+            cur->spatialAccessTotalMid += cur->spatialAccessMid;
+            cur->smplMiddle += cur->spatialAccessMid;
+            cur->spatialAccessMid = 0;
+          }
+        }
+      }
+      for (uint32_t i = 0; i < numRef; i++){
+        if (sampleLast[i] != 0){
+          SpatialRUD *cur = getPair(i, pageID);
+          cur->spatialDistance = time - sampleLast[i] - 1;
+          if (cur->spatialAccessMid == 0){
+            cur->spatialTotalDistance += cur->spatialDistance;
+            cur->spatialAccess++;
+          }
+          cur->spatialAccessMid++;
+        }
+      }
+    }
+    sampleLast[pageID] = time;
+  }
+
+  void endSample(uint32_t *sampleLifetime, uint32_t *inSampleLifetimeCnt){
+    for (auto it = spatialRUD.begin(); it != spatialRUD.end(); ++it){
+      SpatialRUD *cur = it->second;
+      uint32_t curPageID = it->first / numBlk;
+      if (sampleLifetime[curPageID] != 0){
+        cur->smplAvgSpatialMiddle = ((cur->smplAvgSpatialMiddle * (inSampleLifetimeCnt[curPageID]-1))
+                                     + ((double)(cur->smplMiddle)/((double)sampleLifetime[curPageID]))) / (double)inSampleLifetimeCnt[curPageID];
+      }
+      cur->spatialAccessMid = 0;
+      cur->smplMiddle = 0;
+    }
+    sampleLast.assign(numBlk, 0);
+  }
+
+  void setSpatialRUD(uint32_t refBlock, BlockInfo *curBlock){
+    for (uint32_t j = 0; j < numBlk; j++){
+      auto it = spatialRUD.find((uint64_t)refBlock * numBlk + j);
+      if (it != spatialRUD.end()){
+        curBlock->setSpatialRUD(j, it->second);
+      }
+    }
+  }
+
+private:
+  uint32_t numRef, numBlk;
+  map<uint64_t, SpatialRUD*> spatialRUD;
+  vector<uint32_t> totalAccess;
+  vector<uint32_t> sampleLast;
+  uint32_t lastPage;
+
+  SpatialRUD* getPair(uint32_t r, uint32_t c){
+    SpatialRUD *&cur = spatialRUD[(uint64_t)r * numBlk + c];
+    if (cur == nullptr){
+      cur = new SpatialRUD(0);
+    }
+    return cur;
+  }
+};
+
+// Sample lifetimes of the reference blocks as spatialAnalysis computes them
+class Lifetime {
+public:
+  vector<uint32_t> life, cnt;
+
+  Lifetime(uint32_t numRefBlocks, uint32_t numBlocks){
+    numRef = numRefBlocks;
+    life.assign(numRefBlocks, 0);
+    cnt.assign(numRefBlocks, 0);
+    last.assign(numBlocks, 0);
+    refDistance.assign(numBlocks, 0);
+  }
+
+  void access(uint32_t pageID, uint32_t time){
+    if (last[pageID] != 0){
+      refDistance[pageID] = time - last[pageID];
+    }
+    if (pageID < numRef){
+      life[pageID] += refDistance[pageID];
+    }
+    last[pageID] = time;
+  }
+
+  void endSample(){
+    for (uint32_t i = 0; i < numRef; i++){
+      if (life[i] != 0){
+        life[i]++;
+        cnt[i]++;
+      }
+    }
+  }
+
+  void newSample(){
+    life.assign(life.size(), 0);
+    last.assign(last.size(), 0);
+    refDistance.assign(refDistance.size(), 0);
+  }
+
+private:
+  uint32_t numRef;
+  vector<uint32_t> last, refDistance;
+};
+
+static bool samePair(SpatialRUD *a, SpatialRUD *b){
+  return a->spatialDistance == b->spatialDistance && a->spatialTotalDistance == b->spatialTotalDistance
+    && a->spatialAccess == b->spatialAccess && a->spatialAccessTotalMid == b->spatialAccessTotalMid
+    && a->spatialNext == b->spatialNext && a->smplMiddle == b->smplMiddle
+    && memcmp(&a->smplAvgSpatialMiddle, &b->smplAvgSpatialMiddle, sizeof(double)) == 0;
+}
+
+// Samples of random lengths in [1, maxLen] over numRefBlocks reference
+// blocks and numBlocks - numRefBlocks other blocks; hotPct% of the accesses
+// go to the first 1/8 of the blocks
+static bool runCase(int id, uint32_t numRefBlocks, uint32_t numBlocks, uint32_t samples, uint32_t maxLen, int hotPct, uint64_t seed){
+  HotColdGen gen(numBlocks, 8, hotPct, seed);
+  MapAffinity mapAffinity(numRefBlocks, numBlocks);
+  SpatialAffinity spatialAffinity(numRefBlocks, numBlocks);
+  Lifetime lifetime(numRefBlocks, numBlocks);
+  vector<uint32_t> totalAccess(numBlocks, 0);
+  uint32_t time = 0;
+  for (uint32_t s = 0; s < samples; s++){
+    uint32_t n = gen.between(1, maxLen);
+    for (uint32_t a = 0; a < n; a++){
+      uint32_t b = gen.next();
+      time++;
+      totalAccess[b]++;
+      lifetime.access(b, time);
+      mapAffinity.access(b, time, a == 0);
+      spatialAffinity.access(b, time, a == 0);
+    }
+    lifetime.endSample();
+    mapAffinity.endSample(lifetime.life.data(), lifetime.cnt.data());
+    spatialAffinity.endSample(lifetime.life.data(), lifetime.cnt.data());
+    lifetime.newSample();
+  }
+
+  uint64_t pairs = 0;
+  for (uint32_t i = 0; i < numRefBlocks; i++){
+    if (totalAccess[i] == 0){
+      continue;
+    }
+    BlockInfo mapBlock(make_pair(0, i), 0, 0, numBlocks, 1, "map");
+    BlockInfo block(make_pair(0, i), 0, 0, numBlocks, 1, "affinity");
+    mapAffinity.setSpatialRUD(i, &mapBlock);
+    spatialAffinity.setSpatialRUD(i, &block);
+    if (mapBlock.vecSpatialResult.size() != block.vecSpatialResult.size()){
+      cout << "case " << id << " mismatch: block " << i << " pairs " << block.vecSpatialResult.size()
+           << " expected " << mapBlock.vecSpatialResult.size() << endl;
+      return false;
+    }
+    for (uint32_t k = 0; k < block.vecSpatialResult.size(); k++){
+      uint32_t j = mapBlock.vecSpatialResult[k].first;
+      if (block.vecSpatialResult[k].first != j
+          || !samePair(mapBlock.vecSpatialResult[k].second, block.vecSpatialResult[k].second)){
+        cout << "case " << id << " mismatch: pair " << i << " " << j << endl;
+        return false;
+      }
+    }
+    pairs += block.vecSpatialResult.size();
+  }
+  cout << "case " << id << " blocks " << numRefBlocks << "/" << numBlocks << " samples " << samples
+       << " accesses " << time << " pairs " << pairs << " identical" << endl;
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  bool ok = true;
+  struct { uint32_t numRefBlocks, numBlocks, samples, maxLen; int hotPct; } cases[] = {
+    {1, 1, 50, 20, 0},
+    {16, 18, 200, 600, 0},
+    {64, 96, 200, 600, 50},
+    {256, 320, 50, 1000, 90},
+    {256, 257, 20, 2000, 0},
+    {256, 257, 500, 2, 0}
+  };
+  for (int c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); c++){
+    ok = runCase(c + 1, cases[c].numRefBlocks, cases[c].numBlocks, cases[c].samples, cases[c].maxLen,
+                 cases[c].hotPct, c + 1) && ok;
+  }
+  return ok ? 0 : 1;
+}
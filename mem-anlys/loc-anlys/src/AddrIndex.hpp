@@ -0,0 +1,105 @@
+// -*-Mode: C++;-*-
+//
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Yasodha Suriyakumar
+//***************************************************************************
+
+//***************************************************************************
+#ifndef ADDRINDEX_H
+#define ADDRINDEX_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "TraceLine.hpp"
+#include "../../Parallel.hpp"
+
+using namespace std;
+
+// Trace positions sorted by load address, then by position, so the trace
+// lines of an address range [min, max] are found by binary search and
+// visited without walking the rest of the trace.
+// Built on the first range query, so runs without one do not pay for the
+// sort: chunks of the trace are sorted and then merged pairwise on up to
+// nthreads threads.
+class AddrIndex {
+public:
+  struct Entry {
+    uint64_t loadAddr;
+    uint32_t pos; // position in the trace
+  };
+
+  AddrIndex(vector<TraceLine *>& vecInstAddr, unsigned int _nthreads = thread::hardware_concurrency())
+    : trace(vecInstAddr), nthreads(_nthreads), built(false) {}
+
+  // Entries with load address in [min, max]
+  const Entry* begin(uint64_t min){
+    build();
+    Entry key = {min, 0};
+    return entries.data() + (lower_bound(entries.begin(), entries.end(), key, less) - entries.begin());
+  }
+  const Entry* end(uint64_t max){
+    build();
+    Entry key = {max, UINT32_MAX};
+    return entries.data() + (upper_bound(entries.begin(), entries.end(), key, less) - entries.begin());
+  }
+
+  TraceLine* getTraceLine(const Entry* e) { return trace[e->pos]; }
+
+  size_t size() { return trace.size(); }
+
+private:
+  vector<TraceLine *>& trace;
+  vector<Entry> entries;
+  unsigned int nthreads;
+  bool built;
+
+  static bool less(const Entry& a, const Entry& b){
+    return (a.loadAddr < b.loadAddr) || (a.loadAddr == b.loadAddr && a.pos < b.pos);
+  }
+
+  void build(){
+    if (built){
+      return;
+    }
+    built = true;
+    size_t n = trace.size();
+    entries.resize(n);
+    if (nthreads == 0){
+      nthreads = 1;
+    }
+    size_t chunk = (n + nthreads - 1) / nthreads;
+    if (chunk < 65536){
+      chunk = 65536;
+    }
+    size_t numChunks = (n + chunk - 1) / chunk;
+    parallelFor(numChunks, nthreads, [&](size_t c){
+      size_t lo = c * chunk, hi = min(n, lo + chunk);
+      for (size_t i = lo; i < hi; i++){
+        entries[i].loadAddr = trace[i]->getLoadAddr();
+        entries[i].pos = i;
+      }
+      sort(entries.begin() + lo, entries.begin() + hi, less);
+    });
+    for (size_t width = chunk; width < n; width *= 2){
+      size_t numMerges = (n + 2 * width - 1) / (2 * width);
+      parallelFor(numMerges, nthreads, [&](size_t m){
+        size_t lo = m * 2 * width, mid = min(n, lo + width), hi = min(n, lo + 2 * width);
+        inplace_merge(entries.begin() + lo, entries.begin() + mid, entries.begin() + hi, less);
+      });
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,124 @@
+// -*-Mode: C++;-*-
+//
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Yasodha Suriyakumar
+//***************************************************************************
+
+//***************************************************************************
+#ifndef INSTTABLE_H
+#define INSTTABLE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "hyperloglog.hpp"
+
+using namespace std;
+
+// Summary of the accesses of one instruction
+struct InstSummary {
+  uint32_t accessCount;
+  uint64_t minAddr;
+  uint64_t maxAddr;
+  uint32_t numSamples;      // samples with an access by the instruction
+  uint32_t lastSampleId;
+  hll::HyperLogLog lines;   // distinct 64 B lines accessed - estimate
+};
+
+// Per-instruction summaries, filled while the trace is read (add() for
+// every trace line in trace order), so hot instruction analysis does not
+// scan the trace again.
+// Also keeps the hot instruction candidates of getTopInst: counts of the
+// instructions in the current sample, where instructions with at most 1%
+// of the accesses so far are dropped at every new sample.
+class InstTable {
+public:
+  InstTable(){
+    numInsn = 0;
+    prevSampleId = 0;
+  }
+
+  void add(uint64_t insPtrAddr, uint64_t loadAddr, uint32_t sampleId){
+    auto it = table.find(insPtrAddr);
+    if (it == table.end()){
+      it = table.emplace(insPtrAddr, InstSummary{0, loadAddr, loadAddr, 1, sampleId, hll::HyperLogLog(4)}).first;
+    } else if (it->second.lastSampleId != sampleId){
+      it->second.numSamples++;
+      it->second.lastSampleId = sampleId;
+    }
+    InstSummary &inst = it->second;
+    inst.accessCount++;
+    if (loadAddr < inst.minAddr) inst.minAddr = loadAddr;
+    if (loadAddr > inst.maxAddr) inst.maxAddr = loadAddr;
+    uint64_t line = loadAddr >> 6;
+    inst.lines.add((const char *) &line, sizeof(line));
+
+    // hot instruction candidates
+    if (numInsn == 0){
+      prevSampleId = sampleId;
+    }
+    numInsn++;
+    if (sampleId != prevSampleId){
+      prune(0.01);
+    }
+    hotMap[insPtrAddr]++;
+    prevSampleId = sampleId;
+  }
+
+  // Summary of insPtrAddr, nullptr if it is not in the trace
+  const InstSummary* find(uint64_t insPtrAddr){
+    auto it = table.find(insPtrAddr);
+    return (it == table.end()) ? nullptr : &it->second;
+  }
+
+  size_t size() { return table.size(); }
+
+  // Up to 10 hot instructions with more than 2% of the accesses - <IP, count>
+  void getTopInst(vector<pair<uint64_t,uint32_t>>& vecInstAccessCount){
+    prune(0.02);
+    vector <pair<uint32_t,uint64_t>> sortInstr;
+    vector <pair<uint32_t,uint64_t>>::iterator itr;
+    for (auto it=hotMap.begin(); it!=hotMap.end(); it++){
+      sortInstr.push_back(make_pair(it->second, it->first));
+    }
+    sort(sortInstr.begin(), sortInstr.end(),greater<>());
+    for (itr=sortInstr.begin(); itr!=sortInstr.end(); itr++){
+        printf("getTopInst 2percent %u\t0x%lx \n", itr->first, itr->second);
+    }
+    size_t maxInsnCnt = sortInstr.size()> 10 ? 10 : sortInstr.size();
+    for (size_t itrVec=0; itrVec< maxInsnCnt; itrVec++) {
+     vecInstAccessCount.push_back(make_pair(sortInstr.at(itrVec).second, sortInstr.at(itrVec).first));
+    }
+  }
+
+private:
+  unordered_map<uint64_t, InstSummary> table;
+  unordered_map<uint64_t, uint32_t> hotMap;
+  uint32_t numInsn;
+  uint32_t prevSampleId;
+
+  void prune(double fraction){
+    for (auto it = hotMap.begin(); it != hotMap.end();){
+      if ((it->second) <= fraction*numInsn){
+        it = hotMap.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,90 @@
+// -*-Mode: C++;-*-
+//
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Yasodha Suriyakumar
+//***************************************************************************
+
+//***************************************************************************
+#ifndef SAMPLERUD_H
+#define SAMPLERUD_H
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+// Intra-sample reuse distance of blocks: the number of distinct blocks
+// accessed since the previous access to the same block in the sample.
+// Accesses in a sample are numbered 1, 2, ...; the latest access number of
+// every block accessed in the sample is marked in a Fenwick tree, so the
+// distance is the count of marks after the block's own mark - O(log n)
+// per access instead of searching and shifting an LRU stack.
+class SampleRUD {
+public:
+  // numBlocks: block ids are in [0, numBlocks)
+  // maxSampleLen: most accesses in one sample
+  SampleRUD(uint32_t numBlocks, uint32_t maxSampleLen){
+    lastTime.assign(numBlocks, 0);
+    tree.assign(maxSampleLen + 1, 0);
+    now = 0;
+  }
+
+  // Records an access to blockID; returns its reuse distance, -1 on the
+  // first access to blockID in the sample
+  int access(uint32_t blockID){
+    now++;
+    int dist = -1;
+    uint32_t t = lastTime[blockID];
+    if (t == 0){
+      touched.push_back(blockID);
+    } else {
+      dist = count(now - 1) - count(t);
+      add(t, -1);
+    }
+    add(now, 1);
+    lastTime[blockID] = now;
+    return dist;
+  }
+
+  // Starts a new sample
+  void newSample(){
+    for (uint32_t i = 0; i < touched.size(); i++){
+      add(lastTime[touched[i]], -1);
+      lastTime[touched[i]] = 0;
+    }
+    touched.clear();
+    now = 0;
+  }
+
+private:
+  vector<int32_t> tree;       // Fenwick tree over access numbers
+  vector<uint32_t> lastTime;  // latest access number of a block, 0 if none
+  vector<uint32_t> touched;   // blocks accessed in the sample
+  uint32_t now;
+
+  void add(uint32_t t, int32_t v){
+    for (; t < tree.size(); t += t & (~t + 1)){
+      tree[t] += v;
+    }
+  }
+
+  // marks in [1, t]
+  int32_t count(uint32_t t){
+    int32_t n = 0;
+    for (; t > 0; t -= t & (~t + 1)){
+      n += tree[t];
+    }
+    return n;
+  }
+};
+
+#endif
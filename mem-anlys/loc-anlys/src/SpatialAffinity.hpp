@@ -0,0 +1,237 @@
+// -*-Mode: C++;-*-
+//
+//*BeginPNNLCopyright********************************************************
+//
+// $HeadURL$
+// $Id:
+//
+//**********************************************************EndPNNLCopyright*
+
+//***************************************************************************
+// $HeadURL$
+//
+// Yasodha Suriyakumar
+//***************************************************************************
+
+//***************************************************************************
+#ifndef SPATIALAFFINITY_H
+#define SPATIALAFFINITY_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "BlockInfo.hpp"
+
+using namespace std;
+
+// Spatial affinity of block pairs <reference block r, block c> for
+// spatialAnalysis, accumulated per access from the in-sample access times
+// of the blocks instead of looping over all blocks:
+// - Next: c is accessed right after r
+// - Access, TotalDistance: first access to c after an access to r in the
+//   sample, and the distance between the two. The pairs are r = the blocks
+//   accessed since the previous access to c (and c itself), so an access
+//   costs its reuse distance. Distance: from the last access to c after r,
+//   set when r is accessed again or the sample ends.
+// - smplMiddle: accesses to c between the first and the last access to r
+//   in the sample, added up each time r is accessed again.
+// Pairs with values are kept in a hash table of plain SpatialRUD structs.
+// Pair <r, c> is also reported with zero values once r is accessed (not
+// first in a sample) after the first access to c.
+class SpatialAffinity {
+public:
+  // numRefBlocks: reference blocks are [0, numRefBlocks)
+  // numBlocks: blocks are [0, numBlocks)
+  SpatialAffinity(uint32_t numRefBlocks, uint32_t numBlocks){
+    numRef = numRefBlocks;
+    numBlk = numBlocks;
+    firstAccess.assign(numBlocks, 0);
+    lastPairAccess.assign(numRefBlocks, 0);
+    rows.resize(numRefBlocks);
+    middleRows.resize(numRefBlocks);
+    sampleLast.assign(numBlocks, 0);
+    sampleTimes.resize(numBlocks);
+    older.assign(numBlocks, NONE);
+    newer.assign(numBlocks, NONE);
+    newest = NONE;
+    lastBlock = NONE;
+  }
+
+  // Access to blockID at time (> 0); newSample - first access of a sample
+  void access(uint32_t blockID, uint32_t time, bool newSample){
+    if (firstAccess[blockID] == 0){
+      firstAccess[blockID] = time;
+      firstOrder.push_back(blockID);
+    }
+    uint32_t prevTime = sampleLast[blockID];
+    if (!newSample){
+      if (lastBlock < numRef){
+        getPair(lastBlock, blockID).spatialNext++;
+      }
+      if (blockID < numRef){
+        lastPairAccess[blockID] = time;
+      }
+      // blockID is accessed again in the sample
+      bool addMiddle = (blockID < numRef) && (prevTime != 0);
+      for (uint32_t r = newest; (r != NONE) && (sampleLast[r] > prevTime); r = older[r]){
+        if (r < numRef){
+          addDistance(getPair(r, blockID), time - sampleLast[r] - 1);
+          openPairs.push_back(make_pair(r, blockID));
+        }
+        if (addMiddle){
+          vector<uint32_t> &times = sampleTimes[r];
+          uint32_t count = times.end() - upper_bound(times.begin(), times.end(), prevTime);
+          addMiddleCount(blockID, r, count).spatialDistance = sampleLast[r] - prevTime - 1;
+        }
+      }
+      if (addMiddle){
+        addDistance(getPair(blockID, blockID), time - prevTime - 1);
+        if (sampleTimes[blockID].size() >= 2){
+          addMiddleCount(blockID, blockID, 1);
+        }
+      }
+    }
+    // blockID is the most recent block of the sample
+    if (prevTime != 0){
+      unlink(blockID);
+    } else {
+      touched.push_back(blockID);
+    }
+    older[blockID] = newest;
+    newer[blockID] = NONE;
+    if (newest != NONE){
+      newer[newest] = blockID;
+    }
+    newest = blockID;
+    sampleLast[blockID] = time;
+    sampleTimes[blockID].push_back(time);
+    lastBlock = blockID;
+  }
+
+  // End of a sample: averages the middle counts of the reference blocks
+  // with a lifetime in the sample
+  void endSample(uint32_t *sampleLifetime, uint32_t *inSampleLifetimeCnt){
+    for (uint32_t k = 0; k < openPairs.size(); k++){
+      uint32_t r = openPairs[k].first, c = openPairs[k].second;
+      if (sampleLast[c] > sampleLast[r]){
+        getPair(r, c).spatialDistance = sampleLast[c] - sampleLast[r] - 1;
+      }
+    }
+    openPairs.clear();
+    for (uint32_t k = 0; k < touched.size(); k++){
+      uint32_t r = touched[k];
+      if (r < numRef){
+        for (uint32_t m = 0; m < middleRows[r].size(); m++){
+          SpatialRUD &pair = pairs[middleRows[r][m]];
+          if (sampleLifetime[r] != 0){
+            pair.smplAvgSpatialMiddle = ((pair.smplAvgSpatialMiddle * (inSampleLifetimeCnt[r]-1))
+                                          + ((double)(pair.smplMiddle)/((double)sampleLifetime[r]))) / (double)inSampleLifetimeCnt[r];
+          }
+          pair.smplMiddle = 0;
+        }
+      }
+      sampleLast[r] = 0;
+      sampleTimes[r].clear();
+    }
+    touched.clear();
+    newest = NONE;
+    lastBlock = NONE;
+  }
+
+  // Sets the pairs of refBlock to curBlock in block order
+  void setSpatialRUD(uint32_t refBlock, BlockInfo *curBlock){
+    vector<uint32_t> blocks;
+    for (uint32_t k = 0; k < firstOrder.size() && firstAccess[firstOrder[k]] <= lastPairAccess[refBlock]; k++){
+      blocks.push_back(firstOrder[k]);
+    }
+    for (uint32_t k = 0; k < rows[refBlock].size(); k++){
+      blocks.push_back(rows[refBlock][k]);
+    }
+    if (blocks.empty()){
+      return;
+    }
+    sort(blocks.begin(), blocks.end());
+    blocks.erase(unique(blocks.begin(), blocks.end()), blocks.end());
+    // Owned by the block results
+    SpatialRUD *rowPairs = new SpatialRUD[blocks.size()];
+    for (uint32_t k = 0; k < blocks.size(); k++){
+      auto it = pairIndex.find(key(refBlock, blocks[k]));
+      if (it != pairIndex.end()){
+        rowPairs[k] = pairs[it->second];
+      }
+      curBlock->setSpatialRUD(blocks[k], &rowPairs[k]);
+    }
+  }
+
+private:
+  enum : uint32_t { NONE = UINT32_MAX };
+  uint32_t numRef, numBlk;
+
+  // Pairs with values
+  unordered_map<uint64_t, uint32_t> pairIndex;
+  vector<SpatialRUD> pairs;
+  vector<vector<uint32_t>> rows;       // blocks of the pairs of a reference block
+  vector<bool> inMiddleRow;
+  vector<vector<uint32_t>> middleRows; // pairs of a reference block with middle counts
+
+  vector<uint32_t> firstAccess;    // time of the first access to a block
+  vector<uint32_t> firstOrder;     // blocks in first access order
+  vector<uint32_t> lastPairAccess; // time of the last access to a reference block, not first in a sample
+
+  // Sample state - blocks touched in the sample, newest to oldest
+  vector<uint32_t> sampleLast;
+  vector<vector<uint32_t>> sampleTimes;
+  vector<uint32_t> older, newer;
+  vector<uint32_t> touched;
+  vector<pair<uint32_t, uint32_t>> openPairs; // <r, c> with an access to c after r
+  uint32_t newest;
+  uint32_t lastBlock;
+
+  uint64_t key(uint32_t r, uint32_t c){
+    return (uint64_t)r * numBlk + c;
+  }
+
+  SpatialRUD& getPair(uint32_t r, uint32_t c){
+    auto it = pairIndex.find(key(r, c));
+    if (it == pairIndex.end()){
+      it = pairIndex.emplace(key(r, c), pairs.size()).first;
+      pairs.push_back(SpatialRUD());
+      rows[r].push_back(c);
+      inMiddleRow.push_back(false);
+    }
+    return pairs[it->second];
+  }
+
+  void addDistance(SpatialRUD &pair, uint32_t distance){
+    pair.spatialDistance = distance;
+    pair.spatialTotalDistance += distance;
+    pair.spatialAccess++;
+  }
+
+  SpatialRUD& addMiddleCount(uint32_t r, uint32_t c, uint32_t count){
+    SpatialRUD &pair = getPair(r, c);
+    pair.spatialAccessTotalMid += count;
+    pair.smplMiddle += count;
+    uint32_t index = pairIndex[key(r, c)];
+    if (!inMiddleRow[index]){
+      inMiddleRow[index] = true;
+      middleRows[r].push_back(index);
+    }
+    return pairs[index];
+  }
+
+  void unlink(uint32_t b){
+    if (older[b] != NONE){
+      newer[older[b]] = newer[b];
+    }
+    if (newer[b] != NONE){
+      older[newer[b]] = older[b];
+    } else {
+      newest = older[b];
+    }
+  }
+};
+
+#endif
@@ -48,6 +48,6 @@ public:
   double   smplAvgSpatialMiddle;
  
 //This class holds the Block's spatial results - spatial distance metrics
- SpatialRUD(uint32_t pageBlkID);
+ SpatialRUD(uint32_t pageBlkID = 0);
 } ; 
   
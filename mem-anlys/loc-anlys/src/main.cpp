@@ -538,6 +538,7 @@ int main(int argc, char ** argv){
 			  printf("--heapAddrEnd\t: Set heap address max value - spcify end (length of address 12), located in memgaze.config file \n"); 
 			  printf("--insn\t: Find instructions in memRange - use with memRange\n");
 			  printf("--count\t: Find cardinality in trace\n");
+			  printf("--threads\t: Threads for sorting the address index - DEFAULT hardware threads\n");
 			  //printf("--bottomUp\t: enable bottom-up analysis - doesnt implement feature yet\n");
 			  return -1;
 		  }
@@ -563,6 +564,7 @@ int main(int argc, char ** argv){
   int bottomUp = 0;
   int getInsn = 0;
   int countCardinality=0;
+  unsigned int numThreads = thread::hardware_concurrency(); // Address index sort
   uint64_t traceMin = stoull("FFFFFF",0,16); // Added for invalid load address checks - range corrected - load address with 0x1d49620 format refers to offset in double ptwrite loads, and perf drops some records resulting in offset loads being reported
   uint64_t traceMax = stoull("8F0000000000", 0, 16); // Omit load addresses beyond stack range - 12 hex digits with 7F..
   uint64_t user_max = 0;
@@ -702,6 +704,11 @@ int main(int argc, char ** argv){
 			printf("--count : Find cardinality for trace %s\n", memoryfile);
       countCardinality = 1;
     }
+		if (strcmp(qpoint, "--threads") == 0){
+			numThreads = atoi(argv[argi]);
+			printf("Using %u threads for the address index\n", numThreads);
+		  argi++;
+		}
   }
   if(zoomLastLvlPageWidth == 16384 || zoomLastLvlPageWidth == 4096)
     levelOneSize = 4194304*16;
@@ -722,7 +729,8 @@ int main(int argc, char ** argv){
   windowMin=0; 
   windowMax=0;
   windowAvg=0.0;
-  int readReturn = readTrace(memoryfile, &intTotalTraceLine, vecInstAddr, &windowMin, &windowMax, &windowAvg, &traceMax, &traceMin, &totalSamples);
+  InstTable instTable;
+  int readReturn = readTrace(memoryfile, &intTotalTraceLine, vecInstAddr, &windowMin, &windowMax, &windowAvg, &traceMax, &traceMin, &totalSamples, instTable);
   if(readReturn == -1) {
     printf("Error in readTrace \n");
     return -1;
@@ -828,9 +836,12 @@ int main(int argc, char ** argv){
   bool blCustomSize = 0;
   int writeReturn=0;
   int analysisReturn=0;
+  // Address range queries go through the index - not the whole trace; it is
+  // sorted on the first query
+  AddrIndex addrIndex(vecInstAddr, numThreads);
   if ((getInsn == 1) && (memRange==1))
   {
-    getInstInRange(nullptr, vecInstAddr, memarea);
+    getInstInRange(nullptr, addrIndex, memarea);
   }
 	//start analysis
 	if(analysis == 1){
@@ -854,8 +865,7 @@ int main(int argc, char ** argv){
           vecBlockInfo.push_back(newBlock);
         }
         printf("Size of vector BlockInfo %ld\n", vecBlockInfo.size());
-	  	  analysisReturn=spatialAnalysis( vecInstAddr, memarea, coreNumber, 0, vecBlockInfo, setRegionAddr, memIncludePages,
-                                  vecParentFamily, vecTopAccessLineAddr,1); //spatialResult =0
+	  	  analysisReturn=getRangeRUD(addrIndex, memarea, vecBlockInfo); // RUD only - lines of memarea
         if(analysisReturn ==-1)
           return -1;
         for(i = 0; i< memarea.blockCount; i++){
@@ -912,10 +922,9 @@ int main(int argc, char ** argv){
         }
         if (memarea.blockSize == cacheLineWidth) { 
           // RUD analyisis only - Affinity analysis not done in this loop - costly space & time overhead
-	  	    analysisReturn=spatialAnalysis( vecInstAddr, memarea, coreNumber, 0, vecBlockInfo, setRegionAddr, memIncludePages,
-                                  vecParentFamily, vecTopAccessLineAddr,1); //spatialResult =0
+	  	    analysisReturn=getRangeRUD(addrIndex, memarea, vecBlockInfo); // RUD only - lines of memarea
         } else {
-          analysisReturn= getAccessCount(vecInstAddr,   memarea,  coreNumber , vecBlockInfo );
+          analysisReturn= getAccessCount(addrIndex,   memarea,  coreNumber , vecBlockInfo );
         }
         if(analysisReturn ==-1) {
           printf("No analysis done\n");
@@ -995,11 +1004,11 @@ int main(int argc, char ** argv){
     vector<std::pair<uint64_t,uint32_t>> vecInstAccessCount;
     vector<std::pair<uint64_t,uint64_t>> vecInstRegion;
     printf(" STEP 0-a get HOT Insn\n");
-    getTopInst(vecInstAddr,vecInstAccessCount);
+    instTable.getTopInst(vecInstAccessCount);
     size_t numHotInsn = vecInstAccessCount.size(); 
     for (size_t cntHotInsn=0; cntHotInsn < numHotInsn; cntHotInsn++)  {
       printf("HOT INSN %08lx count %d\n", vecInstAccessCount.at(cntHotInsn).first, vecInstAccessCount.at(cntHotInsn).second);
-      getRegionforInst(&spatialOutInsnFile, vecInstAddr,vecInstAccessCount.at(cntHotInsn).first, vecInstRegion);
+      getRegionforInst(&spatialOutInsnFile, instTable,vecInstAccessCount.at(cntHotInsn).first, vecInstRegion);
     }
 
     //XSBench get region for 1011be
@@ -1140,7 +1149,7 @@ int main(int argc, char ** argv){
                                               memarea.blockCount+cntAddPages, 0, strNodeId); // spatialResult=0
             vecBlockInfo.push_back(newBlock);
           }
-          analysisReturn= getAccessCount(vecInstAddr,   memarea,  coreNumber , vecBlockInfo );
+          analysisReturn= getAccessCount(addrIndex,   memarea,  coreNumber , vecBlockInfo );
           if(analysisReturn ==-1) {
             printf("No analysis done\n");
             return -1;
@@ -1175,8 +1184,7 @@ int main(int argc, char ** argv){
               vecBlockInfo.push_back(newBlock);
             }
             printf("HOT-INSN RUD Spatial set min-max %08lx-%08lx \n", minRegionAddr, maxRegionAddr);
-	  	      analysisReturn=spatialAnalysis( vecInstAddr, memarea, coreNumber, 0, vecBlockInfo, setRegionAddr, memIncludePages,
-                                  vecParentFamily, vecTopAccessLineAddr,1); //spatialResult =0
+	  	      analysisReturn=getRangeRUD(addrIndex, memarea, vecBlockInfo); // RUD only - lines of memarea
 
             for(i = 0; i< memarea.blockCount; i++){
               BlockInfo *curBlock = vecBlockInfo.at(i);
@@ -1217,7 +1225,7 @@ int main(int argc, char ** argv){
        //--insn  : Find instructions for ../MiniVite_O3_v1_nf_func_8k_P5M_n300k/miniVite_O3-v1.trace.final in memRange 56122007b08a-56122007f089
        spatialOutInsnFile << " --insn  : Find instructions in " << memoryfile << " for memRange " << hex<< insnMemArea.min << "-" 
                           << insnMemArea.max << " ID " << thisMemblock.strID << endl;
-        getInstInRange(&spatialOutInsnFile, vecInstAddr,insnMemArea);
+        getInstInRange(&spatialOutInsnFile, addrIndex,insnMemArea);
     }
     // STEP 1 - Calculate spatial affinity at data object (inter-region) level
     if(setRegionAddr.size() ==0) {
@@ -1312,7 +1320,7 @@ int main(int argc, char ** argv){
                                               memarea.blockCount, 0, mapMinAddrToID[memarea.min]); 
           vecBlockInfo.push_back(newBlock);
         }
-        analysisReturn= getAccessCount(vecInstAddr,   memarea,  coreNumber , vecBlockInfo );
+        analysisReturn= getAccessCount(addrIndex,   memarea,  coreNumber , vecBlockInfo );
         if(analysisReturn ==-1) {
           printf("Spatial Analysis Step 2 - Zoom into objects to find OS page sized %ld B hot blocks returned without results\n", OSPageSize);
           return -1;
@@ -1373,7 +1381,7 @@ int main(int argc, char ** argv){
         vecParentFamily = vecParentChild[parentIndex];
         printf(" in spatial STEP2.6 last %d size %ld count %d memarea.min %08lx memarea.max %08lx parent %s Id %s \n", thisMemblock.level, 
                 thisMemblock.blockSize, thisMemblock.blockCount, thisMemblock.min, thisMemblock.max, thisMemblock.strParentID.c_str(), thisMemblock.strID.c_str());
-        int accessReturn = getTopAccessCountLines(vecInstAddr, thisMemblock, vecParentFamily, vecLineInfo , OSPageSize, cacheLineWidth,cntRegion);
+        int accessReturn = getTopAccessCountLines(addrIndex, thisMemblock, vecParentFamily, vecLineInfo , OSPageSize, cacheLineWidth,cntRegion);
         if(accessReturn !=0) {
           printf("Error - failed in getTopAccessCountLines\n");
           return 0;
@@ -1422,7 +1430,7 @@ int main(int argc, char ** argv){
 	   	insnMemArea.min = ptrTopAccessLine.lowAddr;
       //printf(" after spatial 2.6a %d addr %08lx \n", vecAccessCount.at(cntVecAccess).first, vecAccessCount.at(cntVecAccess).second); 
       spatialOutInsnFile << " --insn  : Find instructions in " << memoryfile << " for memRange " << hex<< insnMemArea.min << "-" << insnMemArea.max << " ID hotline" << endl;
-        getInstInRange(&spatialOutInsnFile, vecInstAddr,insnMemArea);
+        getInstInRange(&spatialOutInsnFile, addrIndex,insnMemArea);
     }
 
     mapAddrHotLine.clear();
@@ -1,4 +1,6 @@
 #include "memoryanalysis.h"
+#include "SampleRUD.hpp"
+#include "SpatialAffinity.hpp"
 
 using namespace std;
 using std::cerr;
@@ -16,14 +18,17 @@ int printProgress =1;
 //Data stored as <IP addr core initialtime\n>
 // Core is not processed in RUD or spatial correlational analysis
 int readTrace(string filename, int *intTotalTraceLine,  vector<TraceLine *>& vecInstAddr, uint32_t *windowMin, uint32_t *windowMax, 
-                            double *windowAvg, uint64_t * max, uint64_t * min, uint32_t * totalSamples)
+                            double *windowAvg, uint64_t * max, uint64_t * min, uint32_t * totalSamples, InstTable& instTable)
 {
+  bool isBinTrace = isTraceBinFile(filename);
 	// File pointer 
   fstream fin; 
-  fin.open(filename, ios::in); 
-  if (!(fin.is_open())) {
-    cout <<"Error in file open - " << filename << endl;
-    return -1; 
+  if (!isBinTrace) {
+    fin.open(filename, ios::in); 
+    if (!(fin.is_open())) {
+      cout <<"Error in file open - " << filename << endl;
+      return -1; 
+    }
   }
   // read the state line
   string line,ip,addr,core, inittime, sampleIdStr;
@@ -48,6 +53,67 @@ int readTrace(string filename, int *intTotalTraceLine,  vector<TraceLine *>& vec
   *min = UINT64_MAX;
   *max = 0;
 
+  // Sample statistics and TraceLine for one trace line within the address thresholds
+  auto addTraceLine = [&]() {
+    if (loadAddr > (*max)) (*max) = loadAddr; //check max
+    if (loadAddr < (*min)) (*min) = loadAddr; //check min
+    if ( (curSampleId ==0) && (prevSampleId ==0)  &&(flFirstLine)) {
+      curSampleId=sampleId;
+      prevSampleId=sampleId;
+      numSamples++;
+      flFirstLine = false;
+    }
+    curSampleId=sampleId;
+    if ( curSampleId != prevSampleId) {
+      if(curSampleCnt < (*windowMin) || (*windowMin ==0))
+         *windowMin = curSampleCnt;
+      if(curSampleCnt > (*windowMax) || (*windowMax ==0))
+        *windowMax = curSampleCnt;
+      *windowAvg = ((double)((*windowAvg)*(numSamples-1))+(double)curSampleCnt)/(double)numSamples;
+      //printf(" curSampleId %d prevSampleId %d average %f curSampleCnt %d numSamples %d\n", curSampleId, prevSampleId, *windowAvg, +curSampleCnt, numSamples);
+      curSampleCnt=0;
+      numSamples++;
+    } else {
+      curSampleCnt++;
+    }  
+    prevSampleId = curSampleId;
+    // USED in GAP verification of access counts - experimental
+    //uint64_t GAP_pr_low_ip = stoull("30a32c", 0, 16);  //uint64_t GAP_pr_high_ip= stoull("30a578", 0, 16);
+    //uint64_t GAP_cc_low_ip = stoull("300ad0", 0, 16); // [0x300ad0-0x300be6)  //uint64_t GAP_cc_high_ip= stoull("300be6", 0, 16);
+    //uint64_t GAP_CSR_low = stoull("3008fe", 0, 16); // [0x300ad0-0x300be6)   //uint64_t GAP_CSR_high = stoull("300a5b", 0, 16);
+    //if((insPtrAddr >= GAP_pr_low_ip) && (insPtrAddr < GAP_pr_high_ip))
+    //{
+      ptrTraceLine=new TraceLine(insPtrAddr, loadAddr, coreNum, instTime, sampleId);
+      vecInstAddr.push_back(ptrTraceLine);
+      instTable.add(insPtrAddr, loadAddr, sampleId);
+    //}
+  };
+
+  if (isBinTrace) {
+    // Binary trace (memgaze-trace-pack): records are read in place from the mmap'ed file
+    TraceBinFile binTrace;
+    if (!binTrace.openFile(filename)) {
+      cout <<"Error in file open - " << filename << endl;
+      return -1; 
+    }
+    const TraceBinRecord *rec = binTrace.records();
+    uint64_t numRecords = binTrace.getNumRecords();
+    vecInstAddr.reserve(vecInstAddr.size() + numRecords);
+    for (uint64_t i = 0; i < numRecords; i++) {
+      (*intTotalTraceLine)++;
+      loadAddr = rec[i].addr;
+      if ((loadAddr > addrLowThreshold) && (loadAddr < addrHighThreshold)) {
+        insPtrAddr = rec[i].ip;
+        coreNum = rec[i].cpu;
+        instTime = rec[i].time / 1000000000; // text trace time is truncated to seconds
+        sampleId = rec[i].sampleID;
+        addTraceLine();
+      }
+    }
+    *totalSamples = numSamples;
+    return 0;
+  }
+
   if(fin.is_open()){
     while(getline(fin, line)){
 		  std::stringstream s(line);
@@ -74,8 +140,6 @@ int readTrace(string filename, int *intTotalTraceLine,  vector<TraceLine *>& vec
      		getline(s,addr,' ');
         loadAddr = stoull(addr,0,16);
         if ((loadAddr > addrLowThreshold) && (loadAddr < addrHighThreshold)) {
-          if (loadAddr > (*max)) (*max) = loadAddr; //check max
-          if (loadAddr < (*min)) (*min) = loadAddr; //check min
           insPtrAddr = stoull(ip,0,16);
       	  getline(s,core,' ');
           coreNum= stoi(core);
@@ -83,35 +147,7 @@ int readTrace(string filename, int *intTotalTraceLine,  vector<TraceLine *>& vec
           instTime= stoull(inittime);
         	getline(s,sampleIdStr,' ');
           sampleId= stoull(sampleIdStr);
-          if ( (curSampleId ==0) && (prevSampleId ==0)  &&(flFirstLine)) {
-            curSampleId=sampleId;
-            prevSampleId=sampleId;
-            numSamples++;
-            flFirstLine = false;
-          }
-          curSampleId=sampleId;
-          if ( curSampleId != prevSampleId) {
-            if(curSampleCnt < (*windowMin) || (*windowMin ==0))
-               *windowMin = curSampleCnt;
-            if(curSampleCnt > (*windowMax) || (*windowMax ==0))
-              *windowMax = curSampleCnt;
-            *windowAvg = ((double)((*windowAvg)*(numSamples-1))+(double)curSampleCnt)/(double)numSamples;
-            //printf(" curSampleId %d prevSampleId %d average %f curSampleCnt %d numSamples %d\n", curSampleId, prevSampleId, *windowAvg, +curSampleCnt, numSamples);
-            curSampleCnt=0;
-            numSamples++;
-          } else {
-            curSampleCnt++;
-          }  
-          prevSampleId = curSampleId;
-          // USED in GAP verification of access counts - experimental
-          //uint64_t GAP_pr_low_ip = stoull("30a32c", 0, 16);  //uint64_t GAP_pr_high_ip= stoull("30a578", 0, 16);
-          //uint64_t GAP_cc_low_ip = stoull("300ad0", 0, 16); // [0x300ad0-0x300be6)  //uint64_t GAP_cc_high_ip= stoull("300be6", 0, 16);
-          //uint64_t GAP_CSR_low = stoull("3008fe", 0, 16); // [0x300ad0-0x300be6)   //uint64_t GAP_CSR_high = stoull("300a5b", 0, 16);
-          //if((insPtrAddr >= GAP_pr_low_ip) && (insPtrAddr < GAP_pr_high_ip))
-          //{
-            ptrTraceLine=new TraceLine(insPtrAddr, loadAddr, coreNum, instTime, sampleId);
-            vecInstAddr.push_back(ptrTraceLine);
-          //}
+          addTraceLine();
         }
       } 
     }
@@ -123,25 +159,23 @@ int readTrace(string filename, int *intTotalTraceLine,  vector<TraceLine *>& vec
 /*
 Get IP for data addresses in memarea
 */
-void getInstInRange(std::ofstream *outFile, vector<TraceLine *>& vecInstAddr,MemArea memarea)
+void getInstInRange(std::ofstream *outFile, AddrIndex& addrIndex, MemArea memarea)
 {
-	uint64_t loadAddr =0;  
   std::unordered_map<uint64_t,uint32_t> insMap;
   std::unordered_map<uint64_t,uint32_t>::iterator it;
   uint64_t insPtrAddr;
   TraceLine *ptrTraceLine;
-  for (uint32_t itr=0; itr<vecInstAddr.size(); itr++){
-      ptrTraceLine=vecInstAddr.at(itr);
+  // Only the trace lines with data addresses in memarea
+  const AddrIndex::Entry *itrEnd = addrIndex.end(memarea.max);
+  for (const AddrIndex::Entry *itrAddr = addrIndex.begin(memarea.min); itrAddr < itrEnd; itrAddr++){
+      ptrTraceLine=addrIndex.getTraceLine(itrAddr);
       //ptrTraceLine->printTraceLine();    
-      loadAddr = ptrTraceLine->getLoadAddr();
-    	if((loadAddr>=memarea.min)&&(loadAddr<=memarea.max)){
         insPtrAddr=ptrTraceLine->getInsPtAddr();  
         //printf( "%08lx\n", insPtrAddr);
         if(insMap.find(insPtrAddr)!=insMap.end())
           (insMap.find(insPtrAddr)->second)++;
         else
          insMap[insPtrAddr]=1;
-      }
   }
   vector <pair<uint32_t,uint64_t>> sortInstr;
   vector <pair<uint32_t,uint64_t>>::iterator itr;
@@ -161,88 +195,23 @@ void getInstInRange(std::ofstream *outFile, vector<TraceLine *>& vecInstAddr,Mem
   printf("\n");
 }
 
-void getRegionforInst(std::ofstream *outFile, vector<TraceLine *>& vecInstAddr,uint64_t loadInst, vector<std::pair<uint64_t,uint64_t>>& vecInstRegion)
+void getRegionforInst(std::ofstream *outFile, InstTable& instTable,uint64_t loadInst, vector<std::pair<uint64_t,uint64_t>>& vecInstRegion)
 {
   printf("getRegionforInst  inst %lx ", loadInst);
-  TraceLine *ptrTraceLine;
   uint64_t regLowAddr =0;
   uint64_t regHighAddr =0;
-  uint64_t insPtrAddr;
-	uint64_t loadAddr =0;  
-  for (uint32_t itr=0; itr<vecInstAddr.size(); itr++){
-      ptrTraceLine=vecInstAddr.at(itr);
-        insPtrAddr=ptrTraceLine->getInsPtAddr();  
-        if(loadInst == insPtrAddr) {
-          loadAddr = ptrTraceLine->getLoadAddr();
-          if(( regLowAddr == 0) && (regHighAddr ==0)) {
-            regLowAddr  = loadAddr;
-            regHighAddr = loadAddr;
-          } else {
-              if ( loadAddr < regLowAddr) regLowAddr = loadAddr;
-              if ( loadAddr > regHighAddr) regHighAddr = loadAddr;
-          }
-        }
+  // Address range of the instruction from its summary - no trace scan
+  const InstSummary *instSummary = instTable.find(loadInst);
+  if(instSummary != nullptr) {
+    regLowAddr = instSummary->minAddr;
+    regHighAddr = instSummary->maxAddr;
   }
   printf("getRegionforInst  inst %lx loadInst , low %lx high %lx\n", loadInst, regLowAddr, regHighAddr);
-  vecInstRegion.push_back(make_pair(regLowAddr, regHighAddr));
-}
-
-void getTopInst(vector<TraceLine *>& vecInstAddr,vector<std::pair<uint64_t,uint32_t>>& vecInstAccessCount) 
-{
-  TraceLine *ptrTraceLine;
-  uint64_t insPtrAddr;
-  std::unordered_map<uint64_t,uint32_t> insMap;
-  std::unordered_map<uint64_t,uint32_t>::iterator it;
-  uint32_t curSampleId, prevSampleId; 
-  uint32_t numInsn=0;
-  prevSampleId = vecInstAddr.at(0)->getSampleId();
-  curSampleId = vecInstAddr.at(0)->getSampleId();
-  for (uint32_t itr=0; itr<vecInstAddr.size(); itr++){
-    numInsn++;
-    ptrTraceLine=vecInstAddr.at(itr);
-    insPtrAddr=ptrTraceLine->getInsPtAddr();  
-    curSampleId = ptrTraceLine->getSampleId();
-    if ( curSampleId == prevSampleId) {
-      if(insMap.find(insPtrAddr)!=insMap.end())
-        (insMap.find(insPtrAddr)->second)++;
-      else
-       insMap[insPtrAddr]=1;
-    } else {
-      for(it = insMap.begin(); it != insMap.end();) {
-        if((it->second) <= (0.01)*numInsn) {
-          it = insMap.erase(it);
-        } else {
-          it++;
-        }    
-      }
-      if(insMap.find(insPtrAddr)!=insMap.end())
-        (insMap.find(insPtrAddr)->second)++;
-      else
-       insMap[insPtrAddr]=1;
-    }
-    prevSampleId = curSampleId ;
-  }
-  for(it = insMap.begin(); it != insMap.end();) {
-    if((it->second) <= (0.02)*numInsn) {
-      it = insMap.erase(it);
-    } else {
-      it++;
-    }    
-  }
-  vector <pair<uint32_t,uint64_t>> sortInstr;
-  vector <pair<uint32_t,uint64_t>>::iterator itr;
-  for (it=insMap.begin(); it!=insMap.end(); it++){
-    //printf("%ld\t0x%lx \n", it->second, it->first);
-    sortInstr.push_back(make_pair(it->second, it->first));
-  }
-  sort(sortInstr.begin(), sortInstr.end(),greater<>()); 
-  for (itr=sortInstr.begin(); itr!=sortInstr.end(); itr++){
-      printf("getTopInst 2percent %u\t0x%lx \n", itr->first, itr->second);
-  }
-  size_t maxInsnCnt = sortInstr.size()> 10 ? 10 : sortInstr.size();
-  for (size_t itrVec=0; itrVec< maxInsnCnt; itrVec++) {
-   vecInstAccessCount.push_back(make_pair(sortInstr.at(itrVec).second, sortInstr.at(itrVec).first)); 
+  if(instSummary != nullptr) {
+    printf("getRegionforInst  inst %lx accesses %u samples %u lines %.0f\n", loadInst, instSummary->accessCount,
+            instSummary->numSamples, instSummary->lines.estimate());
   }
+  vecInstRegion.push_back(make_pair(regLowAddr, regHighAddr));
 }
 
 /* Update trace wih region Id based on load address
@@ -282,8 +251,7 @@ int updateTraceRegion(vector<TraceLine *>& vecInstAddr ,vector<pair<uint64_t, ui
 /* 
 Get access count only - NO RUD analysis
 */
-int getAccessCount(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int coreNumber , vector<BlockInfo *>& vecBlockInfo ){
-  TraceLine *ptrTraceLine;
+int getAccessCount(AddrIndex& addrIndex,  MemArea memarea,  int coreNumber , vector<BlockInfo *>& vecBlockInfo ){
 	uint32_t * totalAccess = new uint32_t [memarea.blockCount]; //Total memory access
 	uint64_t loadAddr =0;  
   uint32_t i;
@@ -291,21 +259,16 @@ int getAccessCount(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int core
 	for(i = 0; i < memarea.blockCount; i++){
 	  totalAccess[i] = 0;
   }
-  for (uint32_t itr=0; itr<vecInstAddr.size(); itr++){
-    if(printProgress) {
-      if(itr%4000000==0) printf("in getAccessCount procesing trace line %d\n", itr);
-    }
-    ptrTraceLine=vecInstAddr.at(itr);
-    loadAddr = ptrTraceLine->getLoadAddr();
-    //if(printDebug) printf("previous Addr %08lx less than %d greater than %d \n", loadAddr, (loadAddr<=memarea.max), (loadAddr>=memarea.min));
-    if(( (loadAddr>=memarea.min)&&(loadAddr<=memarea.max) ) ){
+  // Only the trace lines with data addresses in memarea
+  const AddrIndex::Entry *itrEnd = addrIndex.end(memarea.max);
+  for (const AddrIndex::Entry *itrAddr = addrIndex.begin(memarea.min); itrAddr < itrEnd; itrAddr++){
+      loadAddr = itrAddr->loadAddr;
       pageID = floor((loadAddr-memarea.min)/memarea.blockSize);
       // Number of blocks does not evenly divide address space - so the last one includes spill-over address range
       if(pageID == memarea.blockCount) {
          pageID--;
       }
       totalAccess[pageID]++;
-    }
   }
   if(printDebug) printf("Size of vector %ld\n", vecBlockInfo.size());
   if(!vecBlockInfo.empty()){
@@ -320,14 +283,112 @@ int getAccessCount(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int core
   return 0;
 }
 
-int getTopAccessCountLines(vector<TraceLine *>& vecInstAddr,   Memblock memRegion, vector<pair<uint64_t, uint64_t>> vecParentChild,
+/*
+RUD analysis only - same results as spatialAnalysis with spatialResult = 0 and affinityOption = 1,
+from the trace lines in memarea - NOT the whole trace.
+Lines of memarea are visited in trace order, time is the trace position. Lines outside memarea
+between two lines of a sample are accesses to the bucket of all other addresses, one access is 
+enough for the distinct block counts. Lines of a sample are contiguous in the trace.
+*/
+int getRangeRUD(AddrIndex& addrIndex,  MemArea memarea, vector<BlockInfo *>& vecBlockInfo ){
+  uint32_t numBlocks = memarea.blockCount + 1; // all other addresses lumped into one bucket
+  const AddrIndex::Entry *itrEnd = addrIndex.end(memarea.max);
+  vector<AddrIndex::Entry> vecRange(addrIndex.begin(memarea.min), itrEnd);
+  sort(vecRange.begin(), vecRange.end(), 
+       [](const AddrIndex::Entry& a, const AddrIndex::Entry& b){ return a.pos < b.pos; });
+  if(printProgress) printf("Range RUD analysis address range %08lx - %08lx lines %ld\n", memarea.min, memarea.max, vecRange.size());
+
+  // Sample of each line; intra-sample RUD - sized by the longest sample
+  vector<uint32_t> vecSampleId(vecRange.size());
+  uint32_t maxSampleLen = 0, curSampleLen = 0;
+  for (size_t itr=0; itr<vecRange.size(); itr++){
+    vecSampleId[itr] = addrIndex.getTraceLine(&vecRange[itr])->getSampleId();
+    if ((itr!=0) && (vecSampleId[itr] != vecSampleId[itr-1]))
+      curSampleLen = 0;
+    else if ((itr!=0) && (vecRange[itr].pos > vecRange[itr-1].pos+1))
+      curSampleLen++; // other addresses in between
+    curSampleLen++;
+    if (curSampleLen > maxSampleLen) maxSampleLen = curSampleLen;
+  }
+  SampleRUD sampleRUD(numBlocks, maxSampleLen);
+
+  vector<uint32_t> totalAccess(numBlocks, 0), inSampleAccess(numBlocks, 0), inSampleTotalRUD(numBlocks, 0);
+  vector<uint32_t> inSampleRUDAvgCnt(numBlocks, 0), sampleRefdistance(numBlocks, 0), sampleLastAccess(numBlocks, 0);
+  vector<uint32_t> sampleLifetime(numBlocks, 0), sampleTotalLifetime(numBlocks, 0), inSampleLifetimeCnt(numBlocks, 0);
+  vector<double> inSampleAvgRUD(numBlocks, -1);
+  uint32_t i, pageID, time;
+  int sampleDistance;
+  for (size_t itr=0; itr<vecRange.size(); itr++){
+    // START - new sample
+    if ((itr!=0) && (vecSampleId[itr] != vecSampleId[itr-1])) {
+      for(i = 0; i < memarea.blockCount; i++){
+        if(sampleLifetime[i]!=0) {
+          sampleLifetime[i]++; // Lifetime = total distance between first and last access +1 
+          sampleTotalLifetime[i]++;
+          inSampleLifetimeCnt[i]++;
+        }
+      }
+      for(i = 0; i < memarea.blockCount; i++){
+        if (inSampleAccess[i] > 1) {
+          if(inSampleAvgRUD[i] == -1)
+            inSampleAvgRUD[i] = 0; 
+          inSampleRUDAvgCnt[i]++;
+          inSampleAvgRUD[i] = ((inSampleAvgRUD[i]*(inSampleRUDAvgCnt[i]-1)) + (double)inSampleTotalRUD[i]/(double)(inSampleAccess[i] -1)) / inSampleRUDAvgCnt[i];
+        }
+        inSampleTotalRUD[i] =0;
+        inSampleAccess[i] = 0;
+        sampleLastAccess[i]=0;
+        sampleRefdistance[i]=0;
+        sampleLifetime[i]=0;
+      }
+      sampleRUD.newSample();
+    } else if ((itr!=0) && (vecRange[itr].pos > vecRange[itr-1].pos+1)) {
+      sampleRUD.access(memarea.blockCount);
+    }
+    // END - new sample
+    pageID = floor((vecRange[itr].loadAddr-memarea.min)/memarea.blockSize);
+    // Number of blocks does not evenly divide address space - so the last one includes spill-over address range
+    if(pageID == memarea.blockCount) pageID--;
+    time = vecRange[itr].pos + 1;
+    totalAccess[pageID]++;
+    inSampleAccess[pageID]++;
+    // Distinct blocks since the last access in the sample, -1 on the first access
+    sampleDistance = sampleRUD.access(pageID);
+    if(inSampleAccess[pageID] > 1){
+      inSampleTotalRUD[pageID] = inSampleTotalRUD[pageID] + sampleDistance;  
+      sampleRefdistance[pageID] = time - sampleLastAccess[pageID];
+    }
+    sampleTotalLifetime[pageID] +=  sampleRefdistance[pageID];
+    sampleLifetime[pageID] +=  sampleRefdistance[pageID];
+    sampleLastAccess[pageID] = time;
+  }
+  // Add the last sample RUD to the averages
+  for(i = 0; i < memarea.blockCount; i++){
+    if (inSampleAccess[i] > 1) {
+      if(inSampleAvgRUD[i] == -1)
+        inSampleAvgRUD[i] = 0; 
+      inSampleRUDAvgCnt[i]++;
+      inSampleAvgRUD[i] = (inSampleAvgRUD[i]*(inSampleRUDAvgCnt[i]-1) + (double)inSampleTotalRUD[i]/(double)(inSampleAccess[i] -1)) / inSampleRUDAvgCnt[i];
+    }
+  }
+  if(!vecBlockInfo.empty()){
+    for(i = 0; i < memarea.blockCount; i++){
+      BlockInfo *curBlock = vecBlockInfo.at(i);
+      curBlock->setAccessRUD(totalAccess[i], 0, sampleTotalLifetime[i], inSampleAvgRUD[i]);
+    }
+  }
+  return 0;
+}
+
+int getTopAccessCountLines(AddrIndex& addrIndex,   Memblock memRegion, vector<pair<uint64_t, uint64_t>> vecParentChild,
                                  vector<TopAccessLine *>& vecLineInfo , uint64_t pageSize, uint64_t lineSize, uint8_t regionId) {
-  TraceLine *ptrTraceLine;
   TopAccessLine *ptrTopAccessLine;
   uint32_t numLinesInPage = (pageSize/lineSize);
   uint32_t numLines = numLinesInPage * (vecParentChild.size()-1);
   // pair <access count, loadAddr>
 	vector <pair<uint32_t ,uint64_t>> totalAccess; 
+  // trace position of the first access to the line - its address is reported
+  vector <uint32_t> firstAccessPos(numLines, 0);
 	uint64_t loadAddr =0;  
   uint32_t i;
   uint32_t pageID = 0 ;
@@ -338,11 +399,10 @@ int getTopAccessCountLines(vector<TraceLine *>& vecInstAddr,   Memblock memRegio
 	for(i = 0; i < numLines; i++){
 	  totalAccess.push_back(make_pair(0,0));
   }
-  for (uint32_t itr=0; itr<vecInstAddr.size(); itr++){
-    ptrTraceLine=vecInstAddr.at(itr);
-    loadAddr = ptrTraceLine->getLoadAddr();
-    //if(printDebug) printf("previous Addr %08lx less than %d greater than %d \n", loadAddr, (loadAddr<=memarea.max), (loadAddr>=memarea.min));
-    if(( (loadAddr>=regLowAddr)&&(loadAddr<=regHighAddr) ) ){
+  // Only the trace lines with data addresses in the region - in address order
+  const AddrIndex::Entry *itrEnd = addrIndex.end(regHighAddr);
+  for (const AddrIndex::Entry *itrAddr = addrIndex.begin(regLowAddr); itrAddr < itrEnd; itrAddr++){
+    loadAddr = itrAddr->loadAddr;
         flInHotPages = false;
         for (uint32_t k=1; k<vecParentChild.size(); k++) {
            if((loadAddr>=vecParentChild[k].first)&&(loadAddr<=vecParentChild[k].second)) {
@@ -353,11 +413,13 @@ int getTopAccessCountLines(vector<TraceLine *>& vecInstAddr,   Memblock memRegio
             }
         }
         if (flInHotPages) { 
-          if ((totalAccess.at(pageID).first)==0) totalAccess.at(pageID).second = loadAddr;
+          if (((totalAccess.at(pageID).first)==0) || (itrAddr->pos < firstAccessPos[pageID])) {
+            totalAccess.at(pageID).second = loadAddr;
+            firstAccessPos[pageID] = itrAddr->pos;
+          }
           (totalAccess.at(pageID).first)++;
           //printf(" Addr %08lx less than %d greater than %d pageID %d \n", loadAddr, (loadAddr<=regLowAddr), (loadAddr>=regHighAddr), pageID);
         }
-      }
     }
     std::sort(totalAccess.begin(), totalAccess.end(), greater<>());
     printf(" in getTopAccessCountLines\n");
@@ -435,9 +497,7 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
 	uint32_t * lastAccess = new uint32_t [numBlocks]; // Record the temp access time
 	uint32_t * sampleLastAccess = new uint32_t [numBlocks]; //Record the temp access time
 	uint32_t * stack = new uint32_t [numBlocks]; //stack distance buffer
-	uint32_t sampleStackLength = 0;
-  uint32_t * sampleStack = new uint32_t [numBlocks]; //stack distance buffer
-  uint32_t i, j;
+  uint32_t i;
 
 	uint32_t * inSampleAccess = new uint32_t [numBlocks];    //Total memory access inside a sample 
 	uint32_t * inSampleTotalRUD = new uint32_t [numBlocks];  //Total RUD inside a sample   
@@ -450,17 +510,28 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
   curSampleId = 0; 
 	uint64_t loadAddr =0;  
 	uint64_t regLowAddr, regHighAddr;   
-  std::map<uint32_t, class SpatialRUD*> spatialRUD;
-  std::map<uint32_t, class SpatialRUD*>::iterator itrSpRUD;
-  SpatialRUD *curSpatialRUD; 
+  SpatialAffinity spatialAffinity(memarea.blockCount, numBlocks);
   //uint32_t * totalCAccess = new uint32_t [coreNumber]; // Ununsed - stored as 0 - Seg faults
   bool blNewSample=1;
+
+  // Intra-sample RUD - sized by the longest sample
+  uint32_t maxSampleLen = 0, curSampleLen = 0;
+  for (uint32_t itr=0; itr<vecInstAddr.size(); itr++){
+    curSampleId = vecInstAddr[itr]->getSampleId();
+    if ((itr!=0) && (curSampleId != prevSampleId))
+      curSampleLen = 0;
+    curSampleLen++;
+    if (curSampleLen > maxSampleLen) maxSampleLen = curSampleLen;
+    prevSampleId = curSampleId;
+  }
+  prevSampleId = 0;
+  curSampleId = 0;
+  SampleRUD sampleRUD(numBlocks, maxSampleLen);
 	
   if(printProgress) printf("in memory analysis before for loop\n");
 	for(i = 0; i < numBlocks; i++){
 		stack[i] = 0;
 		distance[i] = 0;
-		sampleStack[i] = 0;
 		sampleDistance[i] = 0;
 		sampleRefdistance[i] = 0;
 		sampleTotalLifetime[i] = 0;
@@ -478,7 +549,6 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
 	  inSampleAvgRUD[i] = -1; 
 	}
   printf("Spatial analysis before vector procesing address range %08lx - %08lx \n", memarea.min, memarea.max);
-	uint32_t lastPage = 0;
   uint32_t totalinst = 0;
 	uint32_t time = 0 ;
   uint32_t pageID =0;
@@ -521,18 +591,7 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
           inSampleLifetimeCnt[i]++;
          }
       }
-      for( itrSpRUD = spatialRUD.begin(); itrSpRUD!= spatialRUD.end(); ++itrSpRUD){
-        curSpatialRUD = itrSpRUD->second;
-        uint32_t curPageID = floor(itrSpRUD->first/numBlocks);
-        uint32_t corrPageID = floor(itrSpRUD->first%numBlocks);
-        if(sampleLifetime[curPageID]!=0) {
-          curSpatialRUD->smplAvgSpatialMiddle= (( curSpatialRUD->smplAvgSpatialMiddle * (inSampleLifetimeCnt[curPageID]-1))+((double)((curSpatialRUD->smplMiddle))/((double)sampleLifetime[curPageID])))/ (double) inSampleLifetimeCnt[curPageID];
-          if (printDebug == 1) printf(" after curSampleId %d curPageID %d corrPageID %d inSampleLifetimeCnt[%d] %d sampleLifetime %d smplMiddle %d smplAvgSpatialMiddle %f \n", 
-                      curSampleId, curPageID, corrPageID, curPageID, inSampleLifetimeCnt[curPageID], sampleLifetime[curPageID], curSpatialRUD->smplMiddle, curSpatialRUD->smplAvgSpatialMiddle);
-        }
-        curSpatialRUD->spatialAccessMid=0;
-        curSpatialRUD->smplMiddle =0;
-      }
+      spatialAffinity.endSample(sampleLifetime, inSampleLifetimeCnt);
     
       for(i = 0; i < numBlocks; i++){
         if (inSampleAccess[i] > 1) {
@@ -544,13 +603,12 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
         }
         inSampleTotalRUD[i] =0;
         inSampleAccess[i] = 0;
-        sampleStackLength=0;
-        sampleStack[i]=0;
         sampleLastAccess[i]=0;
         sampleRefdistance[i]=0;
         sampleLifetime[i]=0;
         if(printDebug ==1 ) printf(" pageID %d, sampleRef[%d] %d inSampleAccess[%d] %d \n", i,i, sampleRefdistance[i], i, inSampleAccess[i]);
       }
+      sampleRUD.newSample();
       blNewSample=1;
     }
     // END - new sample
@@ -642,89 +700,15 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
     inSampleAccess[pageID]++;
     time = totalinst; 
     if(printDebug ==1 ) printf(" pageID %d, sampleRef[%d] %d inSampleAccess[%d] %d \n", pageID, pageID, sampleRefdistance[pageID], pageID, inSampleAccess[pageID]);
-   	if (inSampleAccess[pageID] == 1){
-      sampleStack[sampleStackLength] = pageID;
-      sampleStackLength++;
-      sampleDistance[pageID] = -1;
-   	} else if(inSampleAccess[pageID] > 1){
-    	//search the page in stack	
-      int samplePos = 0;
-      for(uint32_t j = 0; j< sampleStackLength; ++j){
-     		if(sampleStack[j] == pageID) {
-    				samplePos = j;
-     			break;
-      	}
-      }
-     	sampleDistance[pageID] = sampleStackLength - samplePos-1;
-     	//update the page in stack
-     	for(uint32_t j = samplePos; j< sampleStackLength-1; ++j){
-    			sampleStack[j]=sampleStack[j+1];
-     	}
-    	sampleStack[sampleStackLength-1]= pageID;
+    // Distinct blocks since the last access in the sample, -1 on the first access
+    sampleDistance[pageID] = sampleRUD.access(pageID);
+   	if(inSampleAccess[pageID] > 1){
       inSampleTotalRUD[pageID] = inSampleTotalRUD[pageID] + sampleDistance[pageID];  
         sampleRefdistance[pageID] = time - sampleLastAccess[pageID];
     }
-    if((spatialResult == 1) && (blNewSample==0) && (lastPage < memarea.blockCount)) {
-     		if(totalAccess[lastPage] >= 1) {
-           itrSpRUD = spatialRUD.find((lastPage*numBlocks)+pageID);
-           if (itrSpRUD != spatialRUD.end()) {
-             curSpatialRUD = itrSpRUD->second;
-             (curSpatialRUD->spatialNext)++;
-           } else {
-             curSpatialRUD = new SpatialRUD((lastPage*numBlocks)+pageID);
-             spatialRUD[(lastPage*numBlocks)+pageID] = curSpatialRUD;
-             (curSpatialRUD->spatialNext)++;
-           } 
-          //printf("spatialNext[%d][%d] %d \n", lastPage, pageID, spatialNext[lastPage][pageID]);
-      }
-    }
-    lastPage = pageID;
-     				
-    if((spatialResult == 1) && (blNewSample==0) ) {
-      //record the access in mid
-      if(printDebug) printf("******* %d: page ID %d\n", totalinst, pageID);
-      if(pageID < memarea.blockCount) {
-     	  for(j = 0; j < numBlocks; j++){
-          if(totalAccess[j] !=0) {
-            itrSpRUD = spatialRUD.find((pageID*numBlocks)+j);
-            if (itrSpRUD != spatialRUD.end()) {
-                curSpatialRUD = itrSpRUD->second;
-            } else {
-                curSpatialRUD = new SpatialRUD((pageID*numBlocks)+j);
-                spatialRUD[(pageID*numBlocks)+j] = curSpatialRUD;
-                (curSpatialRUD->spatialAccessMid) =0;
-            }
-            (curSpatialRUD->spatialAccessTotalMid)+=(curSpatialRUD->spatialAccessMid);
-            (curSpatialRUD->smplMiddle)+=(curSpatialRUD->spatialAccessMid);
-            (curSpatialRUD->spatialAccessMid) =0;
-          }
- 			  }
-      }
-      //record spatial distance after i
-      for(i = 0; i < memarea.blockCount; i++){
- 				if(sampleLastAccess[i]!=0){
-          if (totalAccess[i] !=0) {
-            itrSpRUD = spatialRUD.find((i*numBlocks)+pageID);
-            if (itrSpRUD != spatialRUD.end()) {
-              curSpatialRUD = itrSpRUD->second;
-            } else {
-              curSpatialRUD = new SpatialRUD((i*numBlocks)+pageID);
-              spatialRUD[(i*numBlocks)+pageID] = curSpatialRUD;
-            }
-      		  curSpatialRUD->spatialDistance= time - sampleLastAccess[i]-1; // Calculate interval distance - access counts between the two
-        	  if(curSpatialRUD->spatialAccessMid==0){
-      	  		curSpatialRUD->spatialTotalDistance += curSpatialRUD->spatialDistance;
-        		  curSpatialRUD->spatialAccess++;
-            }
-    			  curSpatialRUD->spatialAccessMid++;
-            if(printDebug) printf(" time %d, pageID %d, i %d, curSpatialRUD->spatialAccessMid %d curSpatialRUD->spatialAccessMid %d\n", time, pageID, i,  
-                                        curSpatialRUD->spatialAccessMid, curSpatialRUD->smplMiddle );
-            if(printDebug ) printf(" totalAccess[%d] %d time %d, pageID %d, i %d, curSpatialRUD->spatialAccess %d curSpatialRUD->spatialTotalDistance %d\n", i, 
-                                        totalAccess[i], time, pageID, i,  curSpatialRUD->spatialAccess, curSpatialRUD->spatialTotalDistance );
-          }
-    	 	}
-    	}
-    }
+    // Spatial affinity of pageID with the blocks accessed before it in the sample
+    if(spatialResult == 1)
+      spatialAffinity.access(pageID, time, blNewSample);
     if(pageID < memarea.blockCount){
      		sampleTotalLifetime[pageID] +=  sampleRefdistance[pageID];
      		sampleLifetime[pageID] +=  sampleRefdistance[pageID];
@@ -756,18 +740,7 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
          inSampleLifetimeCnt[i]++;
        }
     }
-    for( itrSpRUD = spatialRUD.begin(); itrSpRUD!= spatialRUD.end(); ++itrSpRUD){
-      curSpatialRUD = itrSpRUD->second;
-      uint32_t curPageID = floor(itrSpRUD->first/numBlocks);
-      uint32_t corrPageID = floor(itrSpRUD->first%numBlocks);
-      if(printDebug) printf(" curSampleId %d curPageID %d corrPageID %d sampleLifetime %d smplMiddle %d smplAvgSpatialMiddle %f \n", 
-                              curSampleId, curPageID, corrPageID, sampleLifetime[curPageID], curSpatialRUD->smplMiddle, curSpatialRUD->smplAvgSpatialMiddle);
-      if(sampleLifetime[curPageID]!=0) {
-        curSpatialRUD->smplAvgSpatialMiddle= (( curSpatialRUD->smplAvgSpatialMiddle * (inSampleLifetimeCnt[curPageID]-1))+((double)((curSpatialRUD->smplMiddle))/((double)sampleLifetime[curPageID])))/ (double) inSampleLifetimeCnt[curPageID];
-      }
-      curSpatialRUD->spatialAccessMid=0;
-      curSpatialRUD->smplMiddle =0;
-    }
+    spatialAffinity.endSample(sampleLifetime, inSampleLifetimeCnt);
   }
     
   if(printDebug) printf("Size of vector %ld\n", vecBlockInfo.size()); 
@@ -779,27 +752,10 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
       //curBlock->printBlockRUD();
     }
   }
-  if (printDebug) {
-    for (itrSpRUD = spatialRUD.begin(); itrSpRUD!=spatialRUD.end(); ++itrSpRUD) {
-      curSpatialRUD = itrSpRUD->second;
-      printf("Spatial hash i %d, j %d \n", (itrSpRUD->first)/numBlocks, (itrSpRUD->first)%numBlocks); 
-      uint32_t curPageID = floor(itrSpRUD->first/numBlocks);
-      uint32_t corrPageID = floor(itrSpRUD->first%numBlocks);
-      printf(" curSampleId %d curPageID %d corrPageID %d sampleLifetime %d smplMiddle %d smplAvgSpatialMiddle %f \n", 
-                        curSampleId, curPageID, corrPageID, sampleLifetime[curPageID], curSpatialRUD->smplMiddle, curSpatialRUD->smplAvgSpatialMiddle);
-      }
-  }
-
   for(i = 0; i < memarea.blockCount; i++){
     if(totalAccess[i]!=0) {  
       BlockInfo *curBlock = vecBlockInfo.at(i);
-      for(j = 0; j < numBlocks; j++){
-        itrSpRUD = spatialRUD.find((i*numBlocks)+j);
-        if (itrSpRUD != spatialRUD.end()) {
-           curBlock->setSpatialRUD(j, itrSpRUD->second);
-           //printf("Spatial assign  i %d, j %d \n"  , i, j);
-        }
-      }
+      spatialAffinity.setSpatialRUD(i, curBlock);
     }
   }
 
@@ -809,7 +765,6 @@ int spatialAnalysis(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int cor
 	delete[] distance;
 	delete[] sampleDistance ;
   delete[] sampleRefdistance;
-  delete[] sampleStack;
 	delete[] sampleTotalLifetime; 
 	delete[] sampleLifetime ;
 	delete[] inSampleLifetimeCnt; 
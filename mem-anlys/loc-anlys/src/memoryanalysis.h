@@ -4,22 +4,28 @@
 #include "structure.h"
 #include "TraceLine.hpp"
 #include "BlockInfo.hpp"
+#include "AddrIndex.hpp"
+#include "InstTable.hpp"
+#include "../../TraceBin.hpp"
 #include <stdio.h>
 
 
 //Data stored as <IP addr core initialtime\n>
 // Core is not processed in RUD or spatial correlational analysis
+// Instruction summaries of the trace lines read are added to instTable
 int readTrace(string filename, int *intTotalTraceLine,  vector<TraceLine *>& vecInstAddr, uint32_t *windowMin, uint32_t *windowMax, 
-                            double *windowAvg, uint64_t * max, uint64_t * min, uint32_t * totalSamples) ;
-void getInstInRange(std::ofstream *outFile, vector<TraceLine *>& vecInstAddr,MemArea memarea) ;
-void getRegionforInst(std::ofstream *outFile, vector<TraceLine *>& vecInstAddr,uint64_t loadInst, vector<std::pair<uint64_t,uint64_t>>& vecInstRegion) ;
+                            double *windowAvg, uint64_t * max, uint64_t * min, uint32_t * totalSamples, InstTable& instTable) ;
+void getInstInRange(std::ofstream *outFile, AddrIndex& addrIndex, MemArea memarea) ;
+void getRegionforInst(std::ofstream *outFile, InstTable& instTable,uint64_t loadInst, vector<std::pair<uint64_t,uint64_t>>& vecInstRegion) ;
 
-void getTopInst(vector<TraceLine *>& vecInstAddr,vector<std::pair<uint64_t,uint32_t>>& vecInstAccessCount);
 /*  Get access count only - NO RUD analysis */
-int getAccessCount(vector<TraceLine *>& vecInstAddr,  MemArea memarea,  int coreNumber , vector<BlockInfo *>& vecBlockInfo );
+int getAccessCount(AddrIndex& addrIndex,  MemArea memarea,  int coreNumber , vector<BlockInfo *>& vecBlockInfo );
+
+/*  RUD analysis only from the trace lines in memarea - spatialAnalysis with spatialResult = 0, affinityOption = 1 */
+int getRangeRUD(AddrIndex& addrIndex,  MemArea memarea, vector<BlockInfo *>& vecBlockInfo );
 
 /*  Get highest access cache-lines in region */
-int getTopAccessCountLines(vector<TraceLine *>& vecInstAddr,  Memblock memRegion, vector<pair<uint64_t, uint64_t>> vecParentChild,
+int getTopAccessCountLines(AddrIndex& addrIndex,  Memblock memRegion, vector<pair<uint64_t, uint64_t>> vecParentChild,
                                   vector<TopAccessLine *>& vecLineInfo , uint64_t pageSize, uint64_t lineSize,uint8_t regionId) ;
 
 /* RUD analysis if spatialResult == 0 */
@@ -37,14 +37,22 @@
 #include <math.h>
 #include <list>
 //***************************************************************************
-#include "CPU.hpp"
-#include "AccessTime.hpp"
-#include "Instruction.hpp"
 #include "Window.hpp"
-#include "Address.hpp"
 #include "Function.hpp"
 #include "metrics.hpp"
 #include "Trace.hpp"
+#include "TraceStore.hpp"
+#include "TraceBin.hpp"
+#include "TraceParse.hpp"
+#include "Parallel.hpp"
+#include "FuncIndex.hpp"
+#include "ReuseDist.hpp"
+#include "QuantileSketch.hpp"
+#include "CCT.hpp"
+#include "Focus.hpp"
+#include "Report.hpp"
+#include "ResultCache.hpp"
+#include "Stats.hpp"
 
 #ifdef DEVELOP
 #include "MemgazeSource.hpp"
@@ -53,6 +61,7 @@
 std::ostream ofs(NULL);
 using namespace std;
 #define UINT16MAX 65535
+#define SAMPLE_BATCH_PER_THREAD 64 // samples queued per thread before their trees are built
 
 //Command Parser class
 class CmdOptionParser{
@@ -144,6 +153,18 @@ int getKey(int size){
   return (int)log2((double)size);
 }
 
+//Level of a tree node in treeFPavgMap: log2 of its size, at least 3
+int getTreeKey(int size){
+  int key =  getKey(size);
+  if (key < 3){
+    key = 3;
+  }
+  if (size > pow(2, key)){
+    key++;
+  }
+  return key;
+}
+
 //Print Binary Tree with setting TreeWindowMap
 void printTree (Window * root,  uint32_t period ,uint32_t lvl, map <int, map<enum Metrics, double>> *treeFPavgMap, bool in_sample = false , bool is_load=false){
   map <enum Metrics, double> diagMap; 
@@ -162,13 +183,7 @@ void printTree (Window * root,  uint32_t period ,uint32_t lvl, map <int, map<enu
     root->windowID.second = lvl;
     
     int size  = root->getSize();
-    int key =  getKey(size);
-    if (key < 3){
-      key = 3;
-    }
-    if (size > pow(2, key)){
-      key++;
-    }
+    int key =  getTreeKey(size);
     if (in_sample){
       auto node =  treeFPavgMap->find(key);
       if (node != treeFPavgMap->end()){
@@ -221,7 +236,9 @@ void printTree (Window * root,  uint32_t period ,uint32_t lvl, map <int, map<enu
 }
 
 //building the sample tree
-Window * buildTree( vector <Window *> * windows){ 
+//The windows of a level are paired independently, so with nthreads > 1 the
+//pairs of each level are built on the thread pool
+Window * buildTree( vector <Window *> * windows, unsigned int nthreads = 1){ 
   map <enum Metrics, double> diagMap;
   map <enum Metrics, double> diagMapTemp;
 
@@ -233,38 +250,13 @@ Window * buildTree( vector <Window *> * windows){
   if (windows->size() < 1 || windows == NULL){
     return NULL;
   }
-  vector <Window *> n_windows;
-  Window * newWindow;
-  pair<unsigned long, uint32_t> windowID;
-  uint32_t lvl;
+  vector <Window *> n_windows((windows->size() + 1) / 2);
   
-  if (windows->size() == 2){ 
-    vector <Window *>::iterator  it = windows->begin();
-    vector <Window *>::iterator sit = (it + 1);
-    if (sit == windows->end() || it == windows->end()) {
-      cout << "!!!ERROR at least one window is missing with only 2 left\n";
-      return NULL;
-    }
-    lvl = (*it)->getWindowID().second;
-    if (lvl < (*sit)->getWindowID().second){
-      lvl = (*sit)->getWindowID().second;
-    }
-
-    newWindow = new Window();
-    newWindow->addLeftChild((*it));
-    newWindow->addRightChild((*sit));
-    windowID = (*it)->getWindowID();
-    windowID.second =  lvl+1;
-    newWindow->setID(windowID);
-    (*it)->setParent (newWindow);
-    (*sit)->setParent (newWindow);
-//OZGURCLEANUP DEPRICATE ??  newWindow->setFuncName();
-    if (newWindow == NULL){                       // based on max FP or trace
-      cout << "Returning a NULL window\n";
-    }  
-    return newWindow;
-  } 
-  for(auto it = windows->begin(); it != windows->end(); it++) {
+  parallelFor(n_windows.size(), nthreads, [&](size_t i){
+    Window * newWindow;
+    pair<unsigned long, uint32_t> windowID;
+    uint32_t lvl;
+    vector <Window *>::iterator it = windows->begin() + 2 * i;
     vector <Window *>::iterator sit = (it + 1);
     if (sit != windows->end()) {
       lvl = (*it)->getWindowID().second;
@@ -272,7 +264,7 @@ Window * buildTree( vector <Window *> * windows){
         lvl = (*sit)->getWindowID().second;
       }
 
-      newWindow = new Window();
+      newWindow = new Window((*it)->trace->store);
       newWindow->addLeftChild((*it));
       newWindow->addRightChild((*sit));
 
@@ -283,27 +275,339 @@ Window * buildTree( vector <Window *> * windows){
 
       (*it)->setParent (newWindow);
       (*sit)->setParent (newWindow);
-      n_windows.push_back(newWindow);
-      it++; 
     } else {
       //create a new window only change windowID lvl
-      newWindow =  nullptr;
-      newWindow = new Window();
+      newWindow = new Window((*it)->trace->store);
       newWindow->addLeftChild((*it));
       windowID = (*it)->getWindowID();
       lvl = (*it)->getWindowID().second;
       windowID.second = lvl+1;
       newWindow->setID(windowID);
 //OZGURCLEANUP DEPRICATE ??      newWindow->setFuncName();
-
-      n_windows.push_back(newWindow);
     }
+    n_windows[i] = newWindow;
+  });
+  return buildTree(&n_windows, nthreads);
+}
+
+//Deletes a window and all of its children
+void deleteTree(Window * root){
+  if (root == NULL){
+    return;
   }
-  return buildTree(&n_windows);
+  deleteTree(root->left);
+  deleteTree(root->right);
+  delete root;
 }
 
+// Streaming forest (-S): each sample tree is folded into treeFPavgMap as
+// soon as the sample ends and is then freed. The forest above the samples
+// is built as a binary counter that keeps only the footprint map and load
+// counts of pending nodes, so the window tree needs memory for the largest
+// sample plus log2(#samples) footprint maps instead of the whole trace.
+// Every node is folded with the values printTree records for it in the
+// forest built by buildTree, and the IN_SAMPLE flag of a level follows the
+// pre-order of printTree.
+class StreamForest {
+  public:
+    StreamForest (TraceStore *_store, uint32_t _period, map <int, map<enum Metrics, double>> *_treeFPavgMap){
+      store = _store;
+      period = _period;
+      treeFPavgMap = _treeFPavgMap;
+      nsamples = 0;
+    }
+
+    uint32_t getNumSamples(){ return nsamples;}
+
+    // Pending nodes and level bookkeeping, so that the samples of a later
+    // trace part continue this forest (incremental state; Archive: CacheFile)
+    template <class Archive>
+    void serialize(Archive &ar){
+      ar.item(nsamples);
+      ar.item(lastSample);
+      ar.item(lastForest);
+      uint64_t n = pending.size();
+      ar.item(n);
+      if (ar.isReading()){
+        pending.resize(n);
+      }
+      for (uint64_t i = 0; i < n; i++){
+        ForestNode &p = pending[i];
+        if (ar.isReading()){
+          p.w = NULL;
+        }
+        bool present = (p.w != NULL);
+        ar.item(present);
+        if (!present){
+          continue;
+        }
+        ar.item(p.level);
+        ar.item(p.first_sample);
+        ar.item(p.loads);
+        ar.item(p.constant_lds);
+        if (ar.isReading()){
+          p.w = new Window(store);
+          p.w->setPeriod(period);
+        }
+        p.w->serializeFP(ar);
+      }
+    }
+
+    // Folds a finished sample tree (root from buildTree) and frees it
+    void addSample(Window * sampleHead, bool is_load){
+      map <int, double> nodes;
+      for (auto it = treeFPavgMap->begin(); it != treeFPavgMap->end(); it++){
+        nodes[it->first] = it->second[NUMBER_OF_NODES];
+      }
+      ForestNode node;
+      node.level = 0;
+      node.first_sample = nsamples;
+      node.loads = sampleHead->trace->getSize();
+      node.constant_lds = 0;
+      for (auto ait = sampleHead->trace->trace.begin(); ait != sampleHead->trace->trace.end(); ait++){
+        node.constant_lds += store->extra_frame_lds[*ait];
+      }
+      printTree(sampleHead, period, 0, treeFPavgMap, false, is_load);
+      for (auto it = treeFPavgMap->begin(); it != treeFPavgMap->end(); it++){
+        auto nit = nodes.find(it->first);
+        if (nit == nodes.end() || nit->second != it->second[NUMBER_OF_NODES]){
+          lastSample[it->first] = nsamples;
+        }
+      }
+      node.w = new Window(store);
+      node.w->setPeriod(period);
+      node.w->moveFP(sampleHead);
+      deleteTree(sampleHead);
+      nsamples++;
+
+      uint32_t lvl = 0;
+      while (lvl < pending.size() && pending[lvl].w != NULL){
+        node = mergeNodes(pending[lvl], node);
+        pending[lvl].w = NULL;
+        lvl++;
+      }
+      if (lvl == pending.size()){
+        pending.push_back(node);
+      } else {
+        pending[lvl] = node;
+      }
+    }
+
+    // Pairs the pending nodes as buildTree does and returns the root
+    Window * finish(){
+      ForestNode carry;
+      carry.w = NULL;
+      for (uint32_t lvl = 0; lvl < pending.size() || carry.w != NULL; lvl++){
+        bool higher = false;
+        for (uint32_t h = lvl + 1; h < pending.size(); h++){
+          if (pending[h].w != NULL){
+            higher = true;
+          }
+        }
+        ForestNode curr;
+        curr.w = NULL;
+        if (lvl < pending.size()){
+          curr = pending[lvl];
+          pending[lvl].w = NULL;
+        }
+        if (curr.w != NULL && carry.w != NULL){
+          carry = mergeNodes(curr, carry);
+        } else if (curr.w != NULL || carry.w != NULL){
+          if (curr.w != NULL){
+            carry = curr;
+          }
+          if (!higher){
+            break;
+          }
+          // odd node at the end of a level gets a single-child parent
+          foldNode(carry);
+          carry.level++;
+        }
+      }
+      if (carry.w == NULL){
+        return NULL;
+      }
+      // root keeps its trace in buildTree, so printTree counts its constant loads twice
+      if (carry.level > 0){
+        addTreeFPavg(getTreeKey(carry.loads + 2 * carry.constant_lds), carry.w->getFPSize(),
+                     2 * carry.constant_lds, carry.loads + 2 * carry.constant_lds, carry.first_sample);
+      }
+      for (auto it = lastForest.begin(); it != lastForest.end(); it++){
+        auto sit = lastSample.find(it->first);
+        if (sit == lastSample.end() || it->second > sit->second){
+          (*treeFPavgMap)[it->first][IN_SAMPLE] = 0;
+        }
+      }
+      carry.w->calcFPMetrics();
+      return carry.w;
+    }
+
+  private:
+    struct ForestNode {
+      Window *w;                  // holds the footprint map only
+      uint32_t level;
+      uint32_t first_sample;
+      unsigned long loads;
+      unsigned long constant_lds;
+    };
+
+    TraceStore *store;
+    uint32_t period;
+    uint32_t nsamples;
+    map <int, map<enum Metrics, double>> *treeFPavgMap;
+    vector <ForestNode> pending;      // pending node of each forest level
+    map <int, uint32_t> lastSample;   // level key -> last sample that wrote it
+    map <int, uint32_t> lastForest;   // level key -> last forest node that wrote it
+
+    void addTreeFPavg(int key, double fp, double constant_lds, double size, uint32_t first_sample){
+      auto node = treeFPavgMap->find(key);
+      if (node != treeFPavgMap->end()){
+        node->second[NUMBER_OF_NODES] += 1;
+        node->second[FP] += fp;
+        node->second[CONSTANT] += constant_lds;
+        node->second[WINDOW_SIZE] += size;
+      } else {
+        map <enum Metrics, double> diagMap;
+        diagMap[CONSTANT] = constant_lds;
+        diagMap.insert( {NUMBER_OF_NODES,1});
+        diagMap.insert( {IN_SAMPLE, 0});
+        diagMap.insert( {WINDOW_SIZE, size});
+        diagMap.insert({FP, fp});
+        treeFPavgMap->insert({key, diagMap});
+      }
+      auto lit = lastForest.find(key);
+      if (lit == lastForest.end() || lit->second < first_sample){
+        lastForest[key] = first_sample;
+      }
+    }
+
+    // A forest node that became a child: buildTree drops its trace, so
+    // printTree sees only its constant loads as its size
+    void foldNode(ForestNode &n){
+      if (n.level == 0){
+        return; // sample heads are folded by printTree
+      }
+      addTreeFPavg(getTreeKey(n.constant_lds), n.w->getFPSize(), n.constant_lds,
+                   n.constant_lds, n.first_sample);
+    }
+
+    ForestNode mergeNodes(ForestNode &a, ForestNode &b){
+      foldNode(a);
+      foldNode(b);
+      ForestNode n;
+      n.w = new Window(store);
+      n.w->setPeriod(period);
+      n.level = a.level + 1;
+      n.first_sample = a.first_sample;
+      n.loads = a.loads + b.loads;
+      n.constant_lds = a.constant_lds + b.constant_lds;
+      n.w->moveFP(a.w);
+      if (!n.w->hasFP()){
+        n.w->moveFP(b.w);
+      } else {
+        n.w->addWindow(b.w);
+      }
+      delete a.w;
+      delete b.w;
+      return n;
+    }
+};
+
 //////
 
+// Level averages table of the report; levels of a sample are in sampled
+// loads, levels above them are scaled by multiplier2
+ReportTable levelAverages(string name, map <int, map<enum Metrics, double>> &treeFPavgMap2, double multiplier2){
+  ReportTable t(name);
+  t.column("LVL", REPORT_INT).column("Number_of_Nodes", REPORT_INT);
+  const char *metrics[] = {"Multiplier", "Window_Size", "FP", "Strided_FP", "Indirect_FP", "Constant_Loads", "Unknown",
+                           "Total_Loads", "Cont2Load_ratio", "NPF_Rate", "NPF_Growth_Rate", "Growth_Rate"};
+  for (const char *m : metrics){
+    t.column(m, REPORT_DOUBLE);
+  }
+  for (auto it = treeFPavgMap2.begin(); it != treeFPavgMap2.end(); it ++){
+    int treeLVL = it->first;
+    int n_nodes = treeFPavgMap2[treeLVL][NUMBER_OF_NODES];
+    t.row().put(treeLVL).put(n_nodes);
+    double m = (treeFPavgMap2[treeLVL][IN_SAMPLE] == 0) ? multiplier2 : 1;
+    t.put(m)
+     .put((treeFPavgMap2[treeLVL][WINDOW_SIZE] /n_nodes) * m)
+     .put(( treeFPavgMap2[treeLVL][FP] / n_nodes) * m)
+     .put(( treeFPavgMap2[treeLVL][STRIDED] / n_nodes) * m)
+     .put(( treeFPavgMap2[treeLVL][INDIRECT] / n_nodes) * m)
+     .put(( treeFPavgMap2[treeLVL][CONSTANT] / n_nodes) * m)
+     .put(( treeFPavgMap2[treeLVL][UNKNOWN] / n_nodes) * m)
+     .put(((treeFPavgMap2[treeLVL][WINDOW_SIZE] + treeFPavgMap2[treeLVL][CONSTANT]) /n_nodes) * m);
+    t.put((( treeFPavgMap2[treeLVL][CONSTANT] / n_nodes) * multiplier2) / (((treeFPavgMap2[treeLVL][WINDOW_SIZE] + treeFPavgMap2[treeLVL][CONSTANT]) /n_nodes) * multiplier2 ))
+     .put(( treeFPavgMap2[treeLVL][INDIRECT] / treeFPavgMap2[treeLVL][FP] ))
+     .put((( treeFPavgMap2[treeLVL][INDIRECT] / n_nodes) * multiplier2) / ((treeFPavgMap2[treeLVL][WINDOW_SIZE] /n_nodes) * multiplier2 ))
+     .put((( treeFPavgMap2[treeLVL][FP] / n_nodes) * multiplier2) / ((treeFPavgMap2[treeLVL][WINDOW_SIZE] /n_nodes) * multiplier2));
+  }
+  return t;
+}
+// Footprint and level averages of a focus set (-F): its accesses are cut
+// into leaf windows of leafSize loads per sample as in the main pass and the
+// sample trees are folded by a StreamForest. Returns the root, NULL if the
+// set is empty.
+Window * analyzeFocusSet(FocusSet &set, uint32_t period, int leafSize,
+                         map <int, map<enum Metrics, double>> *treeFPavgMap, bool is_load){
+  TraceStore *store = set.trace->store;
+  StreamForest forest(store, period, treeFPavgMap);
+  vector <Window *> windows;
+  Window * window = NULL;
+  auto endSample = [&](){
+    windows.push_back(window);
+    Window * head = buildTree(&windows);
+    head->sampleHead = true;
+    forest.addSample(head, is_load);
+    windows.clear();
+    window = NULL;
+  };
+  for (size_t i = 0; i < set.trace->trace.size(); i++){
+    uint32_t a = set.trace->trace[i];
+    if (window != NULL && store->sampleID[a] != store->sampleID[set.trace->trace[i - 1]]){
+      endSample();
+    } else if (window != NULL && window->trace->getSize() == leafSize){
+      windows.push_back(window);
+      window = NULL;
+    }
+    if (window == NULL){
+      window = new Window(store);
+      window->setPeriod(period);
+      window->setStime(store->timeOf(a));
+      window->setID({i, 0});
+    }
+    window->setEtime(store->timeOf(a));
+    window->addAccess(a);
+  }
+  if (window != NULL){
+    endSample();
+  }
+  return forest.finish();
+}
+
+// Footprint results of a function, kept in the result cache
+struct FuncResult {
+  int fp;
+  int ncpus;
+  vector <int> cpuFP;
+  int sharedFP;
+  vector <int> cpuSharedFP;
+  map <enum Metrics, double> diagMap;
+  vector <map <enum Metrics, double>> cpuDiagMap;
+
+  template <class Archive>
+  void serialize(Archive &ar){
+    ar.item(fp);
+    ar.item(ncpus);
+    ar.item(cpuFP);
+    ar.item(sharedFP);
+    ar.item(cpuSharedFP);
+    ar.item(diagMap);
+    ar.item(cpuDiagMap);
+  }
+};
+
 int main(int argc, char* argv[], const char* envp[]) {
   // -------------------------------------------------------
   // Parse command line
@@ -312,7 +616,7 @@ int main(int argc, char* argv[], const char* envp[]) {
   //Setting Option Parser
   CmdOptionParser opps(argc, argv);
   if (opps.cmdOptionExists("-h")){
-    cout << "-t Trace File\n-l Load Classification File\n-s hpcstruct File\n-o Graph Output File\n-m Mode o for time based and 1 for load based\n-p Period\n-f Focus Function Name\n-b block size mask def 0xffffffffffff\n-c CallPath File\n-d detailed function view\n -h Help"<<endl;
+    cout << "-t Trace File (text or memgaze-trace-pack binary)\n-l Load Classification File\n-s hpcstruct File(s), comma separated\n-o Graph Output File\n-m Mode o for time based and 1 for load based\n-p Period\n-f Focus Function Name\n-b block size mask def 0xffffffffffff\n-c CallPath File\n-d Detailed function view (per-CPU footprints)\n-j Threads (trace parser, function analysis) def all cores\n-S Stream sample trees (bounded tree memory)\n-e Approximate window footprint with relative error (e.g. 0.01)\n-R Reuse distance histograms\n-C Calling context report (needs -c)\n-F Focus spec file (regions and functions analyzed in one pass)\n-K Result cache directory (reuse the ingested trace and window trees)\n-oc Report CSV prefix (<prefix>.<table>.csv)\n-ob Report binary columnar file\n-I Incremental state file (add this trace part to the earlier parts, implies -S)\n--stats Phase times, peak RSS and loads/s\n -h Help"<<endl;
     return 1;
   }
 
@@ -322,8 +626,9 @@ int main(int argc, char* argv[], const char* envp[]) {
   //OZGURCLEANUP Instruction *ip;
   //OZGURCLEANUP AccessTime *time;
   
-  Access* access;
-  Trace*  trace =  new Trace();;
+  uint32_t access;
+  TraceStore* store = new TraceStore();
+  Trace*  trace =  new Trace(store);
 
   Window * sampleWindow;
   enum Metrics type = UNKNOWN;
@@ -338,18 +643,19 @@ int main(int argc, char* argv[], const char* envp[]) {
   
   unsigned long period = 3000000000;
   
-  vector <unsigned long> Zs;
-  vector <unsigned long> Zt;
-  vector <unsigned long> wSize;
-  vector <unsigned long> wTime;
-  vector <double> wMultipliers;
+  // per-sample statistics
+  QuantileSketch <unsigned long> Zs;
+  QuantileSketch <unsigned long> Zt;
+  QuantileSketch <unsigned long> wSize;
+  QuantileSketch <unsigned long> wTime;
+  QuantileSketch <double> wMultipliers;
 
   //V1:createing the vectors/Maps
   //OZGURCLEANUP vector<AccessTime *> timeVec;
    vector<Window *> sampleVec;
    vector<Window *> funcSampleVec;
   //OZGURCLEANUP vector<AccessTime *> funcVec;//Will hold important function's trace
-  Trace * funcTrace = new Trace();
+  Trace * funcTrace = new Trace(store);
   //map<string, vector<AccessTime *> funcVec;//Will hold all important functions' trace
 
 
@@ -368,7 +674,7 @@ int main(int argc, char* argv[], const char* envp[]) {
   string classificationInputFile = opps.getCmdOption("-l");
   string hpcStructInputFile = opps.getCmdOption("-s");
   string outputFile = opps.getCmdOption("-o");
-  int is_detailed = strtol(opps.getCmdOption("-d").c_str(),NULL,10);
+  bool is_detailed = opps.cmdOptionExists("-d");
   //int is_load = strtol(opps.getCmdOption("-m").c_str(),NULL,10);
   int is_load = 0;
   int is_LDLAT = 0;
@@ -412,118 +718,102 @@ int main(int argc, char* argv[], const char* envp[]) {
   }
   unsigned long regionMinAddr = strtoul(opps.getCmdOption("-rl").c_str(),NULL,16);
   unsigned long regionMaxAddr = strtoul(opps.getCmdOption("-rh").c_str(),NULL,16);
+  // Fold each sample tree as soon as it is built instead of keeping the forest
+  bool do_stream = false;
+  if (opps.cmdOptionExists("-S")){
+    do_stream = true;
+  }
+  // Approximate window footprints with sketches of the given relative error
+  if (opps.cmdOptionExists("-e")){
+    double sketch_err = strtod(opps.getCmdOption("-e").c_str(), NULL);
+    if (sketch_err > 0){
+      Window::sketchPrecision = FPSketch::precisionFor(sketch_err);
+      cout << "Approximate window footprint: sketch precision "<<Window::sketchPrecision
+           <<" std error "<<FPSketch::stdError(Window::sketchPrecision)<<endl;
+    }
+  }
+  // Reuse-distance histograms (MIAMI splay tree) in the -o report
+  bool do_reuse_dist = false;
+  if (opps.cmdOptionExists("-R")){
+    do_reuse_dist = true;
+  }
+  // Focus spec: per region and per function set tables in the -o report
+  bool do_focus_spec = false;
+  string focusSpecFile;
+  if (opps.cmdOptionExists("-F")){
+    do_focus_spec = true;
+    focusSpecFile = opps.getCmdOption("-F");
+  }
+  // Per calling context footprints in the -o report
+  bool do_cct = false;
+  if (opps.cmdOptionExists("-C")){
+    do_cct = true;
+  }
+  // Result cache: ingested trace and main pass results keyed by the inputs
+  bool do_cache = false;
+  string cacheDir;
+  if (opps.cmdOptionExists("-K")){
+    do_cache = true;
+    cacheDir = opps.getCmdOption("-K");
+  }
+  // Incremental mode: the sample statistics, the pending stream forest and
+  // the per-function footprints of the parts analyzed so far are kept in a
+  // state file; each run adds one trace part to them
+  bool do_incremental = false;
+  string incFile;
+  if (opps.cmdOptionExists("-I")){
+    do_incremental = true;
+    do_stream = true;
+    incFile = opps.getCmdOption("-I");
+    if (do_focus || do_focus_spec || do_reuse_dist || do_cct || do_cache){
+      cerr << "Error: -I cannot be combined with -f, -F, -R, -C or -K" << endl;
+      return 1;
+    }
+  }
+  // Phase times and peak RSS
+  bool do_stats = opps.cmdOptionExists("--stats");
+  PhaseStats stats;
+  // Structured report: the tables of the -o report and the per-function
+  // metrics as CSV files and/or one binary columnar file
+  bool do_report_csv = opps.cmdOptionExists("-oc");
+  bool do_report_bin = opps.cmdOptionExists("-ob");
+  string reportCSVPrefix = opps.getCmdOption("-oc");
+  string reportBinFile = opps.getCmdOption("-ob");
+  Report report;
+  // Threads for the text trace parser and the per-function analysis
+  unsigned int nthreads = std::thread::hardware_concurrency();
+  if (opps.cmdOptionExists("-j")){
+    nthreads = strtoul(opps.getCmdOption("-j").c_str(),NULL,10);
+  }
 
 
 
   printf( "Trace InputFile: %s Classication inputFile: %s outputFile: %s\n" ,inputFile.c_str(), classificationInputFile.c_str(), outputFile.c_str());
   
-  fstream outFile, inFile, classInFile, structInFile, cgFile;
+  fstream outFile, inFile, classInFile, cgFile;
   inFile.open(inputFile, ios::in);
   cgFile.open(callGraphFileName, ios::in);
   classInFile.open(classificationInputFile, ios::in);
-  structInFile.open(hpcStructInputFile, ios::in);
   outFile.open(outputFile, ios::out);
   string line;
 
 
 //NATHAN_B
-  //Creating Call graph map
-  //Call graph map  < key, Value>
-  //               < sample id , list<functions>
-  // list of function ordered based on call order 
-  // Example   if f1 -> f2 -> f3 is the call order
-  //       list {f1, f2, f3}
-  string cg_delim = " :*: ";
-  size_t delim_pos = 0;
-  string cg_token;
-
-  list<string> callPath;
-  list<string>::iterator callPathIter;
-
-  string in_cg_name = "";
-  int in_cg_sample_id = 0, cg_sample_id_last= -1;
-
-  // ------------------------------------------------------------
-  // Convert call-path data into Calling Context Tree
-  // ------------------------------------------------------------
-
+  // Calling context tree of the sample call paths; each sample maps to the
+  // CCT node of its call path
+  CCT cct;
+  vector <uint32_t> sampleCCT; // trace sample -> CCT node
   if (cgFile.is_open()) {
-
-    while (getline(cgFile, line)) {
-
-      // -------------------------------------------------------
-      // Parse single line (Call path is multiple lines)
-      // -------------------------------------------------------
-      int token_cnt = 1;
-      while ((delim_pos = line.find(cg_delim)) != std::string::npos) {
-        cg_token = line.substr(0, delim_pos);
-        if (token_cnt == 2) {
-          in_cg_name = cg_token;
-//          cout << "1=TOKEN::"<<cg_token<<endl;
-        } 
-        line.erase(0, delim_pos + cg_delim.length());
-        token_cnt ++;
-      }
-
-      assert(token_cnt == 3);
-      
-      stringstream cg_id_ss(line);
-      cg_id_ss >> in_cg_sample_id;
-//      cout << "2.2TOKEN::"<<line<<endl;
-
-
-      // -------------------------------------------------------
-      // Insert into 'callPath'
-      // -------------------------------------------------------
-
-      //cout << "LAST id: "<<cg_sample_id_last << " CURRENT: "<<in_cg_sample_id<< endl;
-
-      // -------------------------------
-      // case 1: new call path
-      // -------------------------------
-      if (cg_sample_id_last != in_cg_sample_id) {
-
-        // Prior call path is now complete
-	// Commenting out debug messages - appears when callgraph from perf is not empty
-        /*if (!callPath.empty()){
-          cout << "Call path for sample "<<in_cg_sample_id<<endl;
-          for (auto it = callPath.begin(); it != callPath.end(); it++){
-            cout << "\t" <<*it<<endl; 
-          }
-        } */
-
-        // Begin new call path
-        cg_sample_id_last = in_cg_sample_id;
-        callPath.clear();
-        callPath.push_front(in_cg_name);
-      }
-      // -------------------------------
-      // case 2: new frame for continuing current call path
-      // -------------------------------
-      else {
-        callPath.push_front(in_cg_name);
-      }
-    }
-    // -------------------------------------------------------
-    // FIXED: print last path
-    // -------------------------------------------------------
-    // Commenting out debug messages - appears when callgraph from perf is not empty
-    /*cout << "Call path for last sample "<<in_cg_sample_id<<endl;
-    for (auto it = callPath.begin(); it != callPath.end(); it++){
-      cout << "\t" <<*it<<endl; 
-    } */   
+    cct.read(cgFile);
   }
-//End of Call graph reader
 //NATHAN_E
 
 
-  // Here we are reading hpcstruct file  to create function bounds
+  // Here we are reading hpcstruct files  to create function bounds
   unsigned long in_ip, in_addr, in_time;
   unsigned long in_cpu;
-  map <unsigned long , memgaze::Function *> funcMAP; //This will hold start IP to function map
-                                                      //This map is only to know the bounds 
-  map <string, uint32_t> reverseFuncMap;                                                      
-  uint32_t  funcIndex = 0;
+  FuncMap funcMAP; //This will hold <load module, start IP> to function map
+                   //This map is only to know the bounds 
   unsigned long func_start = 0, func_end = 0;
   string func_name;
   memgaze::Function *func;
@@ -533,10 +823,21 @@ int main(int argc, char* argv[], const char* envp[]) {
   std::string addr_deli_e = "-0x";
   std::string name_deli_e = "\" ln=\"";
   size_t spos = 0, epos = 0;
+  FuncIndex funcIndex(store); // IP -> function intervals for attributing loads
 
 //XML READER
+  stats.phase("hpcstruct");
+  // -s takes one or more hpcstruct files separated by ','
   if (do_hpsctruct){
-    if (structInFile.is_open()){
+    std::istringstream structFiles(hpcStructInputFile);
+    string structFile;
+    while (getline(structFiles, structFile, ',')){
+      fstream structInFile(structFile, ios::in);
+      if (!structInFile.is_open()){
+        cerr << "Error in file open - " << structFile << endl;
+        continue;
+      }
+      int lm = -1; // current <LM> load module
       while(getline(structInFile, line)) {
         if (line.find("<HPCToolkitStructure") != std::string::npos){
           in_section=true;
@@ -547,35 +848,58 @@ int main(int argc, char* argv[], const char* envp[]) {
           continue;
         }
         if (in_section){
+          if (line.find("<LM") != std::string::npos){
+            spos = line.find(name_deli_s) + 3;
+            lm = funcIndex.addModule(line.substr(spos, line.find("\"", spos) - spos));
+            continue;
+          }
+          if (lm < 0){
+            lm = funcIndex.addModule(structFile);
+          }
+          // code range of the module from every [lo-hi) of the v="{...}" ranges
+          spos = line.find("v=\"{");
+          epos = line.find("}", spos);
+          while (spos != std::string::npos && (spos = line.find("[0x", spos)) < epos){
+            unsigned long lo = strtoul(line.c_str() + spos + 1, NULL, 16);
+            spos = line.find(addr_deli_e, spos);
+            if (spos == std::string::npos || spos > epos){
+              break;
+            }
+            funcIndex.extendModule(lm, lo, strtoul(line.c_str() + spos + 1, NULL, 16));
+          }
           if (line.find("<P") != std::string::npos){
             std::string name_token = line.substr(line.find(name_deli_s) +3, line.find(name_deli_e)-(line.find(name_deli_s) +3));
             std::string addres_token = line.substr(line.find(addr_deli_s) +5, line.find(addr_deli_e)-(line.find(addr_deli_s) +5));
             std::istringstream ss(addres_token);
             ss >> hex >> func_start;
-            if(!funcMAP.empty()){
-              map <unsigned long , memgaze::Function *>::iterator zz = funcMAP.end();
-              zz --;
-              zz->second->endIP = func_start - 1;
-            }
-            func = new memgaze::Function(name_token ,  func_start,0, 24);
-            funcMAP.insert({func_start, func}); //FIXME modify this to allpw multi LoadModule
-            reverseFuncMap.insert({name_token, funcIndex});
-            funcIndex++;
+            func = new memgaze::Function(store, name_token ,  func_start,0);
+            funcMAP.insert({{(uint16_t)lm, func_start}, func});
+            func->nameID = store->internFunction(name_token);
           }
         }
       }
     }
   }
-  
-
-  map <unsigned long , memgaze::Function *>::iterator mapEndit = funcMAP.end();
-  if (do_hpsctruct){
-    mapEndit --;
-    mapEndit->second->endIP = 0x7FFFFFFFFFFF;
+  funcIndex.build(funcMAP);
+  if (funcIndex.getNumModules() > 1){
+    cout << "Load modules with function bounds: " << funcIndex.getNumModules() << endl;
+  }
+  vector <bool> isFocusFunc(funcIndex.size(), false); // -f name match per interval
+  for (size_t i = 0; do_focus && i < funcIndex.size(); i++){
+    isFocusFunc[i] = (funcIndex.getFunction(i)->name.find(functionName) != std::string::npos);
+  }
+  FocusSpec focusSpec(store);
+  if (do_focus_spec){
+    if (!focusSpec.read(focusSpecFile)){
+      cerr << "Error: cannot open focus spec " << focusSpecFile << endl;
+      return 1;
+    }
+    focusSpec.bindFunctions(funcIndex);
   }
   map <unsigned long, int> frameLdsMap;
   int number_of_lds = 0;
 //Reading load classification file  to build ipTypeMap
+  stats.phase("load-class");
   if (do_lc){
     if (classInFile.is_open()) {  
       while(getline(classInFile, line)) { 
@@ -607,174 +931,272 @@ int main(int argc, char* argv[], const char* envp[]) {
   int trace_size = 0;
   int func_found = 0 , func_not_found= 0 ;
   int loads_from_removed_samples = 0;
-  Instruction * ip_to_add = NULL;
+  long ip_to_add = -1; // store index of the last added access
   int control = 0;
-  map <uint16_t, string> lmMap;
-  map <string, uint16_t> reverselmMap;
   bool isLM = false, anyLM = false;
   bool isTrace = false;
 
-  if(inFile.is_open()){
-    while(getline(inFile, line)){
-      if (line.find("DSO:") != std::string::npos){
-        isLM = true;
-        isTrace = false;
-        continue;
-      } else if (line.find("TRACE:") != std::string::npos){
-        isLM = false;
-        isTrace = true;
-        continue;
-      }
-      if (isLM){
-        std::vector<std::string> dso_elems;
-        split(line, dso_elems);
-        uint16_t dsoID1 = (uint16_t)stoi(dso_elems[1]);
-        string dsoName1 = dso_elems[0];
-        lmMap.insert({dsoID1, dsoName1});
-        reverselmMap.insert({dsoName1, dsoID1});
-        anyLM = true;
-      }
-
-      if ((isTrace && !isLM)|| (!isLM && !isTrace && !anyLM) ){ 
-        trace_size++;
+  // Adds the trace entry held in in_ip, in_addr, in_cpu, in_time,
+  // in_sampleID and load_module_id; shared by the text and binary readers
+  auto addTraceEntry = [&]() {
+    trace_size++;
 //OZGURCLEANUP        reuse = -1;
-        std::vector<std::string> elements;
-        split(line, elements);
-        std::istringstream ss_ip(elements[0]);
-        ss_ip >> std::hex >> in_ip;
-        map<unsigned long ,  enum Metrics>::iterator tit = ipTypeMap.find(in_ip);
-        if(tit != ipTypeMap.end()){
-          type = getTYPE(tit->second);
-        } else {
+    map<unsigned long ,  enum Metrics>::iterator tit = ipTypeMap.find(in_ip);
+    if(tit != ipTypeMap.end()){
+      type = getTYPE(tit->second);
+    } else {
   //FIXME OPEN THIS ERROR        cout << ">>>>>>>> IP for unknown load type is "<< hex<<in_ip<<dec << endl;
-          type = getTYPE(-1);
-        }
-        std::istringstream ss_addr(elements[1]);
-        ss_addr >> hex >> in_addr;
-        if(do_regionAddr) {
-          if( regionMinAddr <= in_addr && regionMaxAddr >= in_addr) 
-            do_addressRange = true;
-          else
-            do_addressRange = false;
-        }
-        if(do_addressRange){
-          in_time = stold(elements[3]) * 1000000000;
-          in_cpu = stold(elements[2]);
-          if (elements.size()>4){
-            in_sampleID = stoi(elements[4]);
-          } else {
-            in_sampleID =  0 ;
-          }
-          if(anyLM){
-            load_module_id = stoi(elements[5]);
-            load_module = lmMap[load_module_id];
-          } else {
-            load_module = "UNKNOWN";
-            load_module_id = UINT16MAX; 
-          }
+      type = getTYPE(-1);
+    }
+    if(do_regionAddr) {
+      if( regionMinAddr <= in_addr && regionMaxAddr >= in_addr) 
+        do_addressRange = true;
+      else
+        do_addressRange = false;
+    }
+    if(do_addressRange){
+      if(anyLM){
+        load_module = store->getLoadModule(load_module_id);
+      } else {
+        load_module = "UNKNOWN";
+        load_module_id = UINT16MAX; 
+      }
 
   //TODO exclude the frame loads and move their frm load exxtras to the next entry
-          map<unsigned long, int>::iterator frameMapIter = frameLdsMap.find(in_ip);
-          int xtr_lds = 0;
-          if (frameMapIter != frameLdsMap.end()){
-            xtr_lds = frameMapIter->second;
-          } else {
-            xtr_lds = 0;
-          }
+      map<unsigned long, int>::iterator frameMapIter = frameLdsMap.find(in_ip);
+      int xtr_lds = 0;
+      if (frameMapIter != frameLdsMap.end()){
+        xtr_lds = frameMapIter->second;
+      } else {
+        xtr_lds = 0;
+      }
 
-          if (type == 0){
+      if (type == 0){
   //        cout << "TYPE 0 before Missing frame loads: "<<missing_frame_loads<< " Extra:"<<xtr_lds<<endl;
-            if( prev_sampleID != 0 && prev_sampleID != in_sampleID){
-              if (ip_to_add != NULL){
-                ip_to_add->setExtraFrameLds(ip_to_add->getExtraFrameLds()+missing_frame_loads);
-                //TODO add missing loads to ip_to_add;
-                ip_to_add = NULL;
-              }
-              loads_from_removed_samples += missing_frame_loads;
-              missing_frame_loads =  xtr_lds + 1;
-            }else{
-              missing_frame_loads = missing_frame_loads + xtr_lds + 1;
-            }
+        if( prev_sampleID != 0 && prev_sampleID != in_sampleID){
+          if (ip_to_add != -1){
+            store->extra_frame_lds[ip_to_add] += missing_frame_loads;
+            //TODO add missing loads to ip_to_add;
+            ip_to_add = -1;
+          }
+          loads_from_removed_samples += missing_frame_loads;
+          missing_frame_loads =  xtr_lds + 1;
+        }else{
+          missing_frame_loads = missing_frame_loads + xtr_lds + 1;
+        }
   //          cout << "TYPE 0 after Missing frame loads: "<<missing_frame_loads<< " Extra:"<<xtr_lds<<endl;
-          } else {
+      } else {
   //        cout << "TYPE 1/2 Missing frame loads: "<<missing_frame_loads<< " Extra:"<<xtr_lds<<endl;
-            if (prev_sampleID == 0) {
-              prev_sampleID = in_sampleID;
-            } else  if (prev_sampleID != in_sampleID ){
-              if (is_in_func){
-                importantWindows++;
-              }
-              totalWindow++;
-              sampleID ++;
-              prev_sampleID = in_sampleID;
-            }
-
+        if (prev_sampleID == 0) {
+          prev_sampleID = in_sampleID;
+        } else  if (prev_sampleID != in_sampleID ){
+          sampleID ++;
+          prev_sampleID = in_sampleID;
+        }
+        if (sampleCCT.size() <= sampleID){
+          sampleCCT.push_back(cct.nodeOf(in_sampleID));
+        }
 
-            elements.erase(elements.begin(), elements.end());
 
-         
-            in_addr = in_addr >> mask;//shiftin to right
-            in_addr = in_addr << mask;//shiftin back to left
+        in_addr = in_addr >> mask;//shiftin to right
+        in_addr = in_addr << mask;//shiftin back to left
 
 
-            //Creating class elements and adding them to the timeMap
+        //Creating class elements and adding them to the timeMap
 //OZGURCLEANUP            addr = new Address(in_addr);
 //OZGURCLEANUP            cpu = new CPU(in_cpu);
 //OZGURCLEANUP            time = new AccessTime(in_time, sampleID);
 //OZGURCLEANUP            ip = new Instruction(in_ip);
-            access =  new Access (in_ip, in_cpu, in_addr, in_time);
+        access = store->addAccess(in_ip, in_cpu, in_addr, in_time, sampleID, type,
+                                  xtr_lds + missing_frame_loads, load_module_id);
 
-            ip_to_add = access->ip;
-         
-            //setting class pointers for each class
+        ip_to_add = access;
+     
+        //setting class pointers for each class
 //OZGURCLEANUP            addr->setAll(in_addr, cpu, time, ip, reuse);
 //OZGURCLEANUP            cpu->setAll(in_cpu, addr, time, ip);
 //OZGURCLEANUP            time->setAll(in_time, sampleID, cpu, addr, ip);
 //OZGURCLEANUP            ip->setAll(in_ip, cpu, time, addr, type);
-            access->time->setSampleID(sampleID);
-            access->ip->setExtraFrameLds(xtr_lds +  missing_frame_loads);
 //OZGURCLEANUP            access->ip->setDSOName(load_module);
-            access->ip->setLoadModule(load_module_id);
-            missing_frame_loads = 0;
-            xtr_lds = 0;
+        missing_frame_loads = 0;
+        xtr_lds = 0;
 
-            //Add the appropriate pointer to appropriate vector
+        //Add the appropriate pointer to appropriate vector
 //OZGURCLEANUP            timeVec.push_back(time);
-            trace->addAccess(access);
-            prevTime = in_time;
-          
-            //Adding check if do_focus
-            if(do_focus){
-              //Check funtion
-              // Here we are getting function info for each entry
-              map <unsigned long, memgaze::Function*>::iterator funcIter;
-              funcIter = funcMAP.upper_bound(in_ip);
-              if (funcIter == funcMAP.end()){
-                func_not_found++;
-                //TODO  OPEN OR DO SMTH      cout << ">>>>>ERROR<<<<< func not found with IP:" <<hex<<currIP<<dec<<endl;
-                continue;
-              } else {
-                func_found++;
-                funcIter--;
-                string currFuncName = funcIter->second->name;
-                if (currFuncName.find(functionName) != std::string::npos ){
-                  is_in_func = true;
-                  func_last_index = func_index; 
-                }
-              }
-              if (is_in_func){
-                funcTrace->addAccess(access); 
-                func_index++;
-              }
-            }
+        trace->addAccess(access);
+        prevTime = in_time;
+      }
+    }
+  };
+
+  stats.phase("ingest");
+  // Result cache keys: the ingested trace depends on the trace, load class
+  // and call path files and the address options; the main pass results
+  // also on the function bounds, -f, the period, the mode and -e
+  uint64_t traceKey = 0, treeKey = 0;
+  if (do_cache){
+    ContentHash th;
+    th.addValue(th.addFile(inputFile));
+    th.addValue(th.addFile(classificationInputFile));
+    th.addValue(th.addFile(callGraphFileName));
+    th.addValue(mask);
+    th.addValue(do_regionAddr);
+    th.addValue(regionMinAddr);
+    th.addValue(regionMaxAddr);
+    traceKey = th.value();
+    ContentHash rh(traceKey);
+    std::istringstream structFiles(hpcStructInputFile);
+    string structFile;
+    while (getline(structFiles, structFile, ',')){
+      rh.addValue(rh.addFile(structFile));
+    }
+    rh.addValue(do_focus);
+    rh.add(functionName);
+    rh.addValue(period);
+    rh.add(mode);
+    rh.addValue(Window::sketchPrecision);
+    treeKey = rh.value();
+  }
+  // Incremental state: the parts share every input and option but the
+  // trace and call path files. The CPUs of the earlier parts come first.
+  uint64_t incKey = 0;
+  CacheFile incState;
+  bool resumed = false;
+  vector <uint16_t> prevCPUs;
+  if (do_incremental){
+    ContentHash ih;
+    ih.addValue(ih.addFile(classificationInputFile));
+    std::istringstream structFiles(hpcStructInputFile);
+    string structFile;
+    while (getline(structFiles, structFile, ',')){
+      ih.addValue(ih.addFile(structFile));
+    }
+    ih.addValue(mask);
+    ih.addValue(do_regionAddr);
+    ih.addValue(regionMinAddr);
+    ih.addValue(regionMaxAddr);
+    ih.addValue(period);
+    ih.add(mode);
+    ih.addValue(Window::sketchPrecision);
+    incKey = ih.value();
+    if (ifstream(incFile).good()){
+      resumed = incState.openRead(incFile, incKey);
+      if (!resumed){
+        cerr << "Error: " << incFile << " is not an incremental state of these inputs and options" << endl;
+        return 1;
+      }
+      incState.item(prevCPUs);
+    }
+  }
+  auto cacheTrace = [&](CacheFile &ar){
+    ar.item(*store);
+    ar.item(trace_size);
+    ar.item(sampleCCT);
+  };
+  CacheFile traceCache;
+  bool cachedTrace = do_cache && traceCache.openRead(CacheFile::pathOf(cacheDir, traceKey, "trace"), traceKey);
+
+  if (cachedTrace){
+    // every ingested load is in the trace
+    cacheTrace(traceCache);
+    traceCache.close();
+    trace->trace.reserve(store->getSize());
+    for (uint32_t a = 0; a < store->getSize(); a++){
+      trace->addAccess(a);
+    }
+    cout << "Result cache: trace hit " << traceCache.getPath() << endl;
+  } else if (isTraceBinFile(inputFile)){
+    // Binary trace (memgaze-trace-pack): records are read in place
+    TraceBinFile binTrace;
+    if (!binTrace.openFile(inputFile)){
+      return 1;
+    }
+    map <uint16_t, string> dsoMap;
+    binTrace.getDSOTable(&dsoMap);
+    for (auto it = dsoMap.begin(); it != dsoMap.end(); it++){
+      store->addLoadModule(it->first, it->second);
+    }
+    anyLM = binTrace.hasDSO();
+    store->reserve(binTrace.getNumRecords());
+    const TraceBinRecord *rec = binTrace.records();
+    for (uint64_t i = 0; i < binTrace.getNumRecords(); i++){
+      in_ip = rec[i].ip;
+      in_addr = rec[i].addr;
+      in_cpu = rec[i].cpu;
+      in_time = rec[i].time;
+      in_sampleID = rec[i].sampleID;
+      load_module_id = anyLM ? rec[i].dso : UINT16MAX;
+      addTraceEntry();
+    }
+  } else if(inFile.is_open()){
+    // Text trace: chunks are parsed in parallel and merged in file order
+    TraceTextParser textTrace;
+    if (textTrace.parseFile(inputFile, nthreads)){
+      for (auto it = textTrace.dsoMap.begin(); it != textTrace.dsoMap.end(); it++){
+        store->addLoadModule(it->first, it->second);
+      }
+      anyLM = textTrace.anyLM;
+      if (textTrace.skipped){
+        cerr << "Skipped " << textTrace.skipped << " malformed trace lines" << endl;
+      }
+      store->reserve(textTrace.getNumRecords());
+      for (auto cit = textTrace.chunks.begin(); cit != textTrace.chunks.end(); cit++){
+        for (auto rit = cit->begin(); rit != cit->end(); rit++){
+          in_ip = rit->ip;
+          in_addr = rit->addr;
+          in_cpu = rit->cpu;
+          in_time = rit->time;
+          in_sampleID = rit->sampleID;
+          if (anyLM){
+            load_module_id = rit->dso;
           }
+          addTraceEntry();
         }
+        vector<TraceBinRecord>().swap(*cit); // release the merged chunk
+      }
+    }
+  }
+  if (do_cache && !cachedTrace){
+    if (traceCache.openWrite(CacheFile::pathOf(cacheDir, traceKey, "trace"), traceKey)){
+      cacheTrace(traceCache);
+      if (traceCache.close()){
+        cout << "Result cache: trace stored " << traceCache.getPath() << endl;
       }
     }
   }
   
+  store->indexCPUs(prevCPUs);
+
+  // Samples and the -f focus trace: once a load of a matching function is
+  // seen every attributed load is in the focus trace; it is cut after the
+  // last matching load below
+  for (uint32_t a = 0; a < store->getSize(); a++){
+    if (a > 0 && store->sampleID[a] != store->sampleID[a - 1]){
+      if (is_in_func){
+        importantWindows++;
+      }
+      totalWindow++;
+    }
+    if (!do_focus){
+      continue;
+    }
+    int funcIdx = funcIndex.find(store->load_module[a], store->ip[a]);
+    if (funcIdx < 0){
+      func_not_found++;
+      continue;
+    }
+    func_found++;
+    if (isFocusFunc[funcIdx]){
+      is_in_func = true;
+      func_last_index = func_index;
+    }
+    if (is_in_func){
+      funcTrace->addAccess(a);
+      func_index++;
+    }
+  }
 //OZGURCLEANUP  cout <<"Total Loads:"<<timeVec.size()<<" Trace Size:"<<trace_size<<endl;
-  cout <<"Total Loads:"<<trace->getSize()<<" Trace Size:"<<trace_size<<endl;
+  cout <<"Total Loads:"<<trace->getSize()<<" Trace Size:"<<trace_size<<" CPUs:"<<store->getNumCPUs()<<endl;
   cout <<" before Total Loads in Function:"<<funcTrace->getSize()<<" Func found:"<<func_found<<" Func not Found: "<<func_not_found<<endl;
   int fsize = funcTrace->getSize();
   funcTrace->removeAfter(func_last_index);
@@ -807,6 +1229,36 @@ int main(int argc, char* argv[], const char* envp[]) {
 //              C3(S1)  C4(S2)
 
   vector <Window *> forest; // This will hold the root of each tree (each sampled period)
+  StreamForest * streamForest = NULL; // replaces forest with -S
+  if (do_stream){
+    streamForest = new StreamForest(store, period, &treeFPavgMap2);
+  }
+  // Sample trees are independent: the leaf windows of each sample are queued
+  // and the trees of a batch of samples are built on the thread pool, then
+  // added to the forest (or folded with -S) in sample order
+  vector <vector <Window *>> sampleWindows;
+  size_t sample_batch = SAMPLE_BATCH_PER_THREAD * max(nthreads, 1U);
+  auto flushSamples = [&](){
+    vector <Window *> sampleTrees(sampleWindows.size());
+    parallelFor(sampleWindows.size(), nthreads, [&](size_t i){
+      sampleTrees[i] = buildTree(&sampleWindows[i]);
+    });
+    for (auto nit = sampleTrees.begin(); nit != sampleTrees.end(); nit++){
+      Window * node = *nit;
+      if (node == NULL){
+        cout << "OZGUR::ERROR NOde IS NULL\n";
+        continue;
+      }
+      node->sampleHead = true;
+      //node->ws = current_ws;//OZGURCLEANUP
+      if (do_stream){
+        streamForest->addSample(node, is_load);
+      } else {
+        forest.push_back(node);
+      }
+    }
+    sampleWindows.clear();
+  };
   vector <Window *> windows; 
   Window * window =  NULL;
   int lvl=0; 
@@ -819,29 +1271,126 @@ int main(int argc, char* argv[], const char* envp[]) {
   unsigned long current_ws = 0 , number_of_windows=0, current_ztime = 0, curr_ws_wo_frames = 0;
   //Function related variables. 
   memgaze::Function * tempFunc = NULL;
-  std::string currFuncName = "";
-  std::string prevFuncName = "";
-  map <unsigned long, memgaze::Function*>::iterator funcIter;
+  int funcIdx;
 
   unsigned long currIP =  0;
   bool isWindowAdded = false; 
-  int lostInstructions= 0; //TODO NOTE:: I am keeping this but not using in anywhere
-  Access * firstAcces =  *(trace->trace.begin());
-  window_first_time = firstAcces->time->time;
+  int lostInstructions= 0; // loads in no function of any load module
+  uint32_t firstAcces =  *(trace->trace.begin());
+  window_first_time = store->timeOf(firstAcces);
 //OZGURCLEANUP  window_first_time = (*timeVec.begin())->time;
-  uint32_t prevSampleID = firstAcces->time->getSampleID();
+  uint32_t prevSampleID = store->sampleID[firstAcces];
   int min_window_size = 7;
   int in_sample_w_size = 0;
   int total_loads_in_trace = 0;
   int total_loads_in_window = 0;
   int ws_wo_frames= 0;
+  uint32_t forest_size = 0;
+  int rootFP = 0;
+  map <pair<uint16_t, unsigned long>, FuncResult> funcResults; // by funcMAP key
+  // Main pass results: with a cached copy the window trees and function
+  // footprints are not rebuilt, the loop below only attributes loads.
+  // Sample statistics are cached as the loop leaves them, the trees and
+  // function footprints once they are computed.
+  auto cacheSamples = [&](CacheFile &ar){
+    ar.item(number_of_windows);
+    ar.item(window_size);
+    ar.item(skip_time);
+    ar.item(window_time);
+    ar.item(Zs);
+    ar.item(Zt);
+    ar.item(wSize);
+    ar.item(wTime);
+    ar.item(wMultipliers);
+  };
+  auto cacheTrees = [&](CacheFile &ar){
+    ar.item(forest_size);
+    ar.item(rootFP);
+    ar.item(treeFPavgMap2);
+    ar.item(funcResults);
+  };
+  // Incremental state after the CPUs: the sample statistics and the state
+  // of the loop at the end of the part, the level sums and the pending
+  // forest before it is finished, then the per-function footprints. A
+  // resumed run continues the loop below as if the parts were one trace;
+  // a part is expected to end on a sample boundary.
+  int parts = 0;
+  int trace_loads = 0; // loads of all parts
+  auto incSamples = [&](CacheFile &ar){
+    ar.item(parts);
+    ar.item(trace_loads);
+    ar.item(number_of_windows);
+    ar.item(window_size);
+    ar.item(skip_time);
+    ar.item(window_time);
+    ar.item(ws_wo_frames);
+    ar.item(Zs);
+    ar.item(Zt);
+    ar.item(wSize);
+    ar.item(wTime);
+    ar.item(wMultipliers);
+    ar.item(total_loads_in_trace);
+    ar.item(total_loads_in_window);
+    ar.item(prevTime);
+    ar.item(window_first_time);
+    ar.item(current_ws);
+    ar.item(curr_ws_wo_frames);
+    ar.item(l_time);
+    ar.item(treeFPavgMap2);
+    ar.item(*streamForest);
+  };
+  // Function footprint and per-CPU tables (by CPU id) and its loads
+  auto incFunction = [&](CacheFile &ar, memgaze::Function *func){
+    int loads = func->getLoads();
+    ar.item(loads);
+    ar.item(func->fpMap);
+    vector <uint16_t> cpus;
+    for (size_t c = 0; c < func->cpuFPMap.size(); c++){
+      cpus.push_back(store->cpuList[c]);
+    }
+    ar.item(cpus);
+    if (ar.isReading()){
+      func->prevLoads = loads;
+      func->cpuFPMap.resize(store->getNumCPUs());
+    }
+    for (size_t c = 0; c < cpus.size(); c++){
+      ar.item(func->cpuFPMap[ar.isReading() ? store->cpuIndex[cpus[c]] : c]);
+    }
+  };
+  if (resumed){
+    incSamples(incState);
+    uint64_t nfuncs = 0;
+    incState.item(nfuncs);
+    for (uint64_t i = 0; i < nfuncs; i++){
+      pair <uint16_t, unsigned long> key;
+      incState.item(key);
+      auto fit = funcMAP.find(key);
+      if (fit != funcMAP.end()){
+        incFunction(incState, fit->second);
+      } else {
+        memgaze::Function unknown(store, "");
+        incFunction(incState, &unknown);
+      }
+    }
+    incState.close();
+    cout << "Incremental state: " << parts << " parts resumed " << incFile << endl;
+  }
+  CacheFile treeCache;
+  bool cachedTree = do_cache && treeCache.openRead(CacheFile::pathOf(cacheDir, treeKey, "tree"), treeKey);
+  if (cachedTree){
+    cacheSamples(treeCache);
+    cacheTrees(treeCache);
+    treeCache.close();
+    cout << "Result cache: tree hit " << treeCache.getPath() << endl;
+  }
 //  bool skip_frame_lds = false;
+  stats.phase("windows");
   cout << "OZGURDBGFRAMELDS total loads before frame loads is "<<trace->getSize()<<endl;
 //  cout << "DEBUG:: Line: " << __LINE__ << endl;
   for(auto it = trace->trace.begin(); it != trace->trace.end(); it++) {
 //    skip_frame_lds = false;
-    total_loads_in_trace = total_loads_in_trace + 1 + (*it)->ip->getExtraFrameLds();
-    total_loads_in_window = total_loads_in_window + 1 + (*it)->ip->getExtraFrameLds();
+    total_loads_in_trace = total_loads_in_trace + 1 + store->extra_frame_lds[*it];
+    total_loads_in_window = total_loads_in_window + 1 + store->extra_frame_lds[*it];
 
 //    cout << "Current Total: "<<total_loads_in_trace<<" extra frame loads: "<<(*it)->ip->getExtraFrameLds()<<endl;;
 //    cout << "OZGUR::Reuse  Address:"<<hex<<(*it)->addr->addr<<dec<< " Reuse: "<<(*it)->addr->rDist;
@@ -855,31 +1404,33 @@ int main(int argc, char* argv[], const char* envp[]) {
 //      timeVec.erase(it);
 //    } else {
     curr_ws_wo_frames++;
-    currIP = (*it)->ip->ip; // instuction IP of current entry
+    currIP = store->ip[*it]; // instuction IP of current entry
 //    cout << " CurrIP: "<<hex<< currIP <<dec<<" time "<<(*it)->time<< " PrevTime "<<prevTime<<" diff "<< (*it)->time - prevTime<<endl;
     
     // Here we are getting function info for each entry
-    funcIter = funcMAP.upper_bound(currIP);
-    if (funcIter == funcMAP.end()){
+    funcIdx = funcIndex.find(store->load_module[*it], currIP);
+    if (funcIdx < 0){
       lostInstructions++;
       //TODO NOTE::  Find the issue in here
 //TODO  OPEN OR DO SMTH      cout << ">>>>>ERROR<<<<< func not found with IP:" <<hex<<currIP<<dec<<endl;
 //      continue; //TODO I remove the continue here since leaf is just each 8 entry but I need to make sure FIXME 
     } else {
-      funcIter--;
-      tempFunc = funcIter->second;
-      currFuncName = tempFunc->name;
+      tempFunc = funcIndex.getFunction(funcIdx);
 //      cout << currFuncName << " size:"<<funcIter->second->timeVec.size() << " adding 0x"<<hex<<(*it)->addr->addr<<dec;
  //OZGURCLEANUP      funcIter->second->timeVec.push_back(*it);
-      funcIter->second->trace->addAccess(*it);
+      tempFunc->trace->addAccess(*it);
  //OZGURCLEANUP      (*it)->addr->setFuncName(currFuncName);
-      uint32_t currFuncID = reverseFuncMap.find(currFuncName)->second;
-      (*it)->ip->setFuncName(currFuncID);
+    }
+    if (do_focus_spec){
+      focusSpec.addAccess(*it, funcIdx);
+    }
+    if (cachedTree){
+      continue;
     }
 
 //Check sample bound
     bool isNewSample =  false;
-      if(prevSampleID != (*it)->time->getSampleID()){
+      if(prevSampleID != store->sampleID[*it] || (resumed && it == trace->trace.begin())){
         isNewSample =  true;
       } else {
         isNewSample =  false;
@@ -892,10 +1443,10 @@ int main(int argc, char* argv[], const char* envp[]) {
       window_size+=current_ws;
       ws_wo_frames+=curr_ws_wo_frames;
 //      cout << "Current w:"<<current_ws << " Tot w:"<<window_size << " #w:"<< number_of_windows;
-      current_ztime = ((*it)->time->time-prevTime);
+      current_ztime = (store->timeOf(*it)-prevTime);
       skip_time+=current_ztime;
 //      cout << " Prev T:"<<prevTime<<" firstT:"<<window_first_time<< " wT:"<<(prevTime - window_first_time);
-      wTime.push_back(prevTime - window_first_time);
+      wTime.add(prevTime - window_first_time);
       unsigned long z_curr;
       if (prevTime - window_first_time){
         z_curr = (current_ws*current_ztime)/(prevTime - window_first_time);
@@ -903,13 +1454,13 @@ int main(int argc, char* argv[], const char* envp[]) {
         z_curr = 0;
       }
       window_time += prevTime - window_first_time;
-      window_first_time =  (*it)->time->time;
+      window_first_time =  store->timeOf(*it);
 //      cout <<" Current Z:"<<z_curr<<" Zt:"<<current_ztime<< " zt:"<<skip_time<<endl;
-      Zs.push_back(z_curr);
-      Zt.push_back(current_ztime);
-      wSize.push_back(current_ws);
+      Zs.add(z_curr);
+      Zt.add(current_ztime);
+      wSize.add(current_ws);
 //      cout <<"MULCHECK " <<windowID.first<<":"<<windowID.second << " SampleID:"<< prevSampleID<<" Period::"<<period<<" total_loads_in_window::"<<total_loads_in_window<<" multiplier::"<<(double)period/(double)total_loads_in_window<<endl;
-      wMultipliers.push_back((double)period/(double)total_loads_in_window);
+      wMultipliers.add((double)period/(double)total_loads_in_window);
       total_loads_in_window = 0;
       curr_ws_wo_frames=0;
       current_ws=0;
@@ -936,24 +1487,22 @@ int main(int argc, char* argv[], const char* envp[]) {
         windows.push_back(window);
       }
 
-// creating tree for current windows and adding them to the forest
-      Window * node;
-      node = buildTree(&windows);
-
-      if (node == NULL)
-        cout << "OZGUR::ERROR NOde IS NULL\n";
-
-      node->sampleHead = true;
-      //node->ws = current_ws;//OZGURCLEANUP
-      forest.push_back(node);
+// queue current windows; their tree is built with the next batch of samples
+// (the last sample of an earlier part was added at the end of that part)
+      if (!windows.empty()){
+        sampleWindows.push_back(windows);
+      }
+      if (sampleWindows.size() >= sample_batch){
+        flushSamples();
+      }
       in_sample_w_size = 0;
 
 // Cleaning windows and creating new window for current entry      
       windows.clear();
       window = nullptr;
-      window =  new Window();
+      window =  new Window(store);
       window->setPeriod(period);
-      window->setStime((*it)->time->time);
+      window->setStime(store->timeOf(*it));
 //OZGURCLEANUP DEPRICATE ??      window->setFuncName(currFuncName);
       window->addAccess((*it));
       windowID = {l_time, lvl};
@@ -963,9 +1512,9 @@ int main(int argc, char* argv[], const char* envp[]) {
              // acually we moved from function boundries to min window size 8
       if (window == NULL){
         //This is the first window
-        window  = new Window();
+        window  = new Window(store);
         window->setPeriod(period);
-        window->setStime((*it)->time->time);
+        window->setStime(store->timeOf(*it));
 //OZGURCLEANUP DEPRICATE ??        window->setFuncName(currFuncName);
         window->addAccess((*it)); 
         windowID = {l_time, lvl};
@@ -975,16 +1524,16 @@ int main(int argc, char* argv[], const char* envp[]) {
         if (in_sample_w_size == min_window_size){
           windows.push_back(window);
           window = nullptr;
-          window  = new Window();
+          window  = new Window(store);
           window->setPeriod(period);
-          window->setStime((*it)->time->time);
+          window->setStime(store->timeOf(*it));
           window->addAccess((*it));
 //OZGURCLEANUP DEPRICATE ??          window->setFuncName(currFuncName);
           windowID = {l_time, lvl};
           window->setID(windowID);
           in_sample_w_size = 0;
         } else { 
-          window->setEtime((*it)->time->time);
+          window->setEtime(store->timeOf(*it));
           window->addAccess((*it));
           in_sample_w_size++;
         }
@@ -994,7 +1543,7 @@ int main(int argc, char* argv[], const char* envp[]) {
 //                                          //If all instanes is the same leaf there wont be a second window.
 ////cout << "DEBUG:: Line: " << __LINE__ << " New Function is "<<currFuncName<<" old Function was "<<window->getFuncName()<<endl;
 //          windows.push_back(window);
-//          window  = new Window();
+//          window  = new Window(store);
 //          window->setStime((*it)->time);
 //          window->addAddress((*it)->addr);
 //          window->setFuncName(currFuncName);
@@ -1009,13 +1558,13 @@ int main(int argc, char* argv[], const char* envp[]) {
       }
     }
     l_time++;
-    prevTime = (*it)->time->time;
-    prevFuncName =  currFuncName ;
-    prevSampleID = (*it)->time->getSampleID();
+    prevTime = store->timeOf(*it);
+    prevSampleID = store->sampleID[*it];
 //    cout << "PrevTime: " << prevTime << " CurrTime: "<<(*it)->time << " Period: " << period << endl;
 //  }
   }
   cout << "OZGURDBGFRAMELDS after timeVec  size  "<<trace->getSize()<<endl;
+  cout << "Loads not in any function: "<<lostInstructions<<endl;
 
 
   cout << "OZGURDBGFRAMELDS total loads after frame loads is "<<total_loads_in_trace<<endl;
@@ -1039,18 +1588,22 @@ int main(int argc, char* argv[], const char* envp[]) {
 //OZGURCLEANUP DEPRICATE ??      window->setFuncName();
       windows.push_back(window);
     }
-    Window * node;
-
-    node = buildTree(&windows);
-    if (node == NULL)
-      cout << "OZGUR::ERROR NOde IS NULL\n";
-    node->sampleHead = true;
-    //node->ws = current_ws; //OZGURCLEANUP
-    forest.push_back(node);
+    sampleWindows.push_back(windows);
     windows.clear();
     window = nullptr;
   }
 
+  flushSamples();
+  trace_loads += trace->getSize();
+  if (do_incremental && incState.openWrite(incFile, incKey)){
+    parts++;
+    incState.item(store->cpuList);
+    incSamples(incState);
+  }
+  if (do_cache && !cachedTree && treeCache.openWrite(CacheFile::pathOf(cacheDir, treeKey, "tree"), treeKey)){
+    cacheSamples(treeCache);
+  }
+
 //  //DEBUG the forest first 
 //  cout << "Debugging forest with "<<forest.size()<<" window\n";
 //  for(auto it = forest.begin() ; it != forest.end(); it++){
@@ -1078,20 +1631,8 @@ int main(int argc, char* argv[], const char* envp[]) {
 //OZGURCLEANUP  double multiplier_ld_mean =0;
   double multiplier_ld_from_totals =0;
   if (number_of_windows > 0){
-    std::sort(wMultipliers.begin(),wMultipliers.end());
-    int size_wMultiplier  = wMultipliers.size();
-//OZGURCLEANUP    if (size_wMultiplier){
-//OZGURCLEANUP      if (size_wMultiplier%2){
-//OZGURCLEANUP        multiplier_ld_median = wMultipliers[size_wMultiplier/2];
-//OZGURCLEANUP      } else {
-//OZGURCLEANUP        multiplier_ld_median = (wMultipliers[size_wMultiplier/2] + wMultipliers[size_wMultiplier/2 -1])/2;
-//OZGURCLEANUP      }
-//OZGURCLEANUP    }
-    double total_of_multipliers = 0;
-    for (int index=0; index< size_wMultiplier; index++){
-//      cout << " Sample Index="<< index<<" multipler="<<wMultipliers[index]<<endl;
-      total_of_multipliers+=wMultipliers[index];
-    }
+//OZGURCLEANUP    multiplier_ld_median = wMultipliers.median();
+    double total_of_multipliers = wMultipliers.sum();
 //OZGURCLEANUP    multiplier_ld_mean = total_of_multipliers/number_of_windows;
     multiplier_ld_from_totals = ((double)number_of_windows*(double)period) / (double)total_loads_in_trace;
   }
@@ -1100,47 +1641,35 @@ int main(int argc, char* argv[], const char* envp[]) {
   //TODO NOTE:: When you are done remove un used ones to clean up
   //Calculating  w and z 
   if (number_of_windows >0 && window_time >0){
-    std::sort(Zs.begin(),Zs.end());
-    std::sort(Zt.begin(),Zt.end());
-    std::sort(wTime.begin(),wTime.end());
-    std::sort(wSize.begin(),wSize.end());
-    int size_Zs =  Zs.size();
-    int size_Zt =  Zt.size();
-    int size_wSize =  wSize.size();
-    int size_wTime =  wTime.size();
-//    cout << "CONTROL:: size of  Zs:"<<size_Zs<<" Zt:"<<size_Zt<<" Ws:"<<size_wSize<<" Wt"<<size_wTime<<endl;
-    if (size_Zs){
-      if (size_Zs%2){
-        skip_size = Zs[size_Zs/2];
-      } else {
-        skip_size = (Zs[size_Zs/2] + Zs[size_Zs/2 -1])/2;
-      }
+//    cout << "CONTROL:: size of  Zs:"<<Zs.count()<<" Zt:"<<Zt.count()<<" Ws:"<<wSize.count()<<" Wt"<<wTime.count()<<endl;
+    // medians are exact up to QSKETCH_K samples, estimates beyond
+    if (Zs.count()){
+      skip_size = Zs.median();
     }
-    if (size_Zt){
-      if (size_Zt%2){
-        zTime1 = Zt[size_Zt/2];
-      } else {
-        zTime1 = (Zt[size_Zt/2] + Zt[size_Zt/2 -1])/2;
-      }
+    if (Zt.count()){
+      zTime1 = Zt.median();
     }
-    if (size_wSize){
-      if (size_wSize%2){
-        wSize1 = wSize[size_wSize/2];
-      } else {
-        wSize1 = (wSize[size_wSize/2] + wSize[size_wSize/2 -1])/2;
-      }
+    if (wSize.count()){
+      wSize1 = wSize.median();
     }
-    if (size_wTime){
-      if (size_wTime%2){
-        wTime1 = wTime[size_wTime/2];
-      } else {
-        wTime1 = (wTime[size_wTime/2] + wTime[size_wTime/2 -1])/2;
-      }
+    if (wTime.count()){
+      wTime1 = wTime.median();
     }
     if (wTime1){
       zSize1 =  (zTime1*wSize1)/wTime1;
     }
     cout<< "CONTROL Median Zs:"<<skip_size<<" Zt:"<<zTime1<<" Ws:"<<wSize1<<" Wt:"<<wTime1<<" Stime: "<<skip_time<<endl;
+    cout << "CONTROL p10/p50/p90/p99 Zs:";
+    Zs.printQuantiles(cout);
+    cout << " Zt:";
+    Zt.printQuantiles(cout);
+    cout << " Ws:";
+    wSize.printQuantiles(cout);
+    cout << " Wt:";
+    wTime.printQuantiles(cout);
+    cout << " Mult:";
+    wMultipliers.printQuantiles(cout);
+    cout << (Zs.isExact() ? "" : " (estimated)") << endl;
     cout << "Window Size "<<window_size << " Wtime: "<<window_time << " #Win: "<<number_of_windows<< endl;
     if (window_time)
       skip_size1 = (skip_time*window_size)/window_time;
@@ -1161,28 +1690,43 @@ int main(int argc, char* argv[], const char* envp[]) {
     cout << "FULL WS:" <<window_size<< " Zt:"<<skip_time << " Wt:"<<window_time<<" ZS:"<<skip_size<<endl;
   }
   
-  cout << "Size of forest is "<<forest.size()<<endl;
+  if (!cachedTree){
+    forest_size = do_stream ? streamForest->getNumSamples() : forest.size();
+  }
+  cout << "Size of forest is "<<forest_size<<endl;
 
   // Calculate footprint with new formulate by using the forest. 
   multiplier = ( ((float)window_size+(float)skip_size)/window_size ); 
   cout << "MULTIPLIERS: xx="<<multiplier;
 
-  Window * fullT;
-  cout << "Building tree Forest size  "<<forest.size()<<endl;
-  fullT = buildTree(&forest );
+  stats.phase("forest");
+  Window * fullT = NULL;
+  cout << "Building tree Forest size  "<<forest_size<<endl;
+  if (cachedTree){
+    // level averages and root footprint come from the cache
+  } else if (do_stream){
+    fullT = streamForest->finish();
+  } else {
+    fullT = buildTree(&forest, nthreads);
+  }
   //TODO FUNCVIEW create forest for each function's trace and sent build tree similart to this.
 //      cout << "Size of head node is "<<fullT->getSize()<<endl;
-  if (fullT == NULL)
+  if (fullT == NULL && !cachedTree)
     cout << "ERROR ROOT IS NULL\n";
   cout << "PRINTING TREE of FP\n";
 
   cout << "General MULTIPLIER="<<multiplier<<endl; //TODO NOTE:: maybe get rid of general completely
   cout << "#windows: "<<number_of_windows<<" Period:"<<period<<" Total Lds:"<< total_loads_in_trace<<endl;
   double multiplier2 = (((double)number_of_windows*(double)period) - (double)total_loads_in_trace) / (double)total_loads_in_trace;
-  double imp_to_all_ratio = (double)total_loads_in_trace / (double)trace->getSize();
+  double imp_to_all_ratio = (double)total_loads_in_trace / (double)trace_loads;
   cout << "General MULTIPLIER with frame loads="<<multiplier2<<endl; //TODO NOTE:: maybe get rid of general completely
-  cout << "Recorded: "<<trace->getSize()<<" supposed to reccord(w/ frame)"<<total_loads_in_trace<<" ratio:"<<imp_to_all_ratio<<endl; //TODO NOTE:: maybe get rid of general completely
-  printTree(fullT , period, 0 , &treeFPavgMap2 , false , is_load); 
+  cout << "Recorded: "<<trace_loads<<" supposed to reccord(w/ frame)"<<total_loads_in_trace<<" ratio:"<<imp_to_all_ratio<<endl; //TODO NOTE:: maybe get rid of general completely
+  if (!do_stream && !cachedTree){
+    printTree(fullT , period, 0 , &treeFPavgMap2 , false , is_load); 
+  }
+  if (fullT != NULL){
+    rootFP = fullT->getFP();
+  }
 //TODO open  printTree(fullT , period,  fullT->windowID.second, false , is_load); 
   //printTree(fullT , &treeFPavgMap, period,  fullT->windowID.second, false , is_load); 
 
@@ -1205,22 +1749,96 @@ int main(int argc, char* argv[], const char* envp[]) {
     multiplier = 1; 
   }
  
+  stats.phase("functions");
   cout << "Function based Flat FP with mutiplier:"<<multiplier<<endl;
   float local_multiplier= 0;
-  for (auto it= funcMAP.begin();it !=funcMAP.end();it++){//TODO actually here first buila a tree for
-                                                         //each function then print tree
-    if (it->second->trace->getSize() > 0){
-      (*it).second->calcFP();
+  // Per-function footprints are independent: compute them on the thread
+  // pool, then report in funcMAP order
+  vector <FuncMap::iterator> funcVec;
+  for (auto it= funcMAP.begin();it !=funcMAP.end();it++){
+    if (it->second->getLoads() > 0){
+      funcVec.push_back(it);
+    }
+  }
+  vector <map <enum Metrics, double>> funcDiagMap(funcVec.size());
+  vector <vector <map <enum Metrics, double>>> funcCPUDiagMap(funcVec.size());
+  if (cachedTree){
+    for (size_t i = 0; i < funcVec.size(); i++){
+      memgaze::Function *func = funcVec[i]->second;
+      FuncResult &r = funcResults[funcVec[i]->first];
+      func->fp = r.fp;
+      func->ncpus = r.ncpus;
+      func->cpuFP = r.cpuFP;
+      func->sharedFP = r.sharedFP;
+      func->cpuSharedFP = r.cpuSharedFP;
+      funcDiagMap[i] = r.diagMap;
+      funcCPUDiagMap[i] = r.cpuDiagMap;
+    }
+  } else {
+    parallelFor(funcVec.size(), nthreads, [&](size_t i){
+      memgaze::Function *func = funcVec[i]->second;
+      func->calcFP();
+      func->getMultiplier(period, is_load);
+      func->getFPDiag(&funcDiagMap[i]);
+      func->calcCPUFP();
+      funcCPUDiagMap[i].resize(func->ncpus);
+      for (int cpuid=0; cpuid<func->ncpus; cpuid++)
+        func->getCPUFPDiag(&(funcCPUDiagMap[i][cpuid]), cpuid);
+    });
+  }
+  if (do_cache && !cachedTree){
+    for (size_t i = 0; i < funcVec.size(); i++){
+      memgaze::Function *func = funcVec[i]->second;
+      FuncResult &r = funcResults[funcVec[i]->first];
+      r.fp = func->fp;
+      r.ncpus = func->ncpus;
+      r.cpuFP = func->cpuFP;
+      r.sharedFP = func->sharedFP;
+      r.cpuSharedFP = func->cpuSharedFP;
+      r.diagMap = funcDiagMap[i];
+      r.cpuDiagMap = funcCPUDiagMap[i];
+    }
+    cacheTrees(treeCache);
+    if (treeCache.close()){
+      cout << "Result cache: tree stored " << treeCache.getPath() << endl;
+    }
+  }
+  if (do_incremental){
+    uint64_t nfuncs = funcVec.size();
+    incState.item(nfuncs);
+    for (size_t i = 0; i < funcVec.size(); i++){
+      pair <uint16_t, unsigned long> key = funcVec[i]->first;
+      incState.item(key);
+      incFunction(incState, funcVec[i]->second);
+    }
+    if (incState.close()){
+      cout << "Incremental state: part " << parts << " stored " << incFile << endl;
+    }
+  }
+  stats.phase("report");
+  const int cellsize = 16;
+  ReportTable &funcTable = report.addTable("functions");
+  funcTable.column("Function", REPORT_STRING).column("StartIP", REPORT_INT, true).column("EndIP", REPORT_INT, true)
+           .column("Size", REPORT_INT).column("FP_Size", REPORT_INT);
+  // Per-CPU function footprints only in the -d detailed view
+  ReportTable funcCPUTable("function_cpus");
+  funcCPUTable.column("Function", REPORT_STRING).column("CPU", REPORT_INT).column("FP_Size", REPORT_INT);
+  const char *funcMetrics[] = {"FP", "Lds", "Collected_Ratio", "Strided", "Indirect", "Constant", "Unknown",
+                               "Multiplier", "Growth_Rate"};
+  for (const char *m : funcMetrics){
+    funcTable.column(m, REPORT_DOUBLE);
+    funcCPUTable.column(m, REPORT_DOUBLE);
+  }
+  funcTable.column("Shared_FP", REPORT_INT);
+  funcCPUTable.column("Shared_FP", REPORT_INT);
+  for (size_t fi = 0; fi < funcVec.size(); fi++){//TODO actually here first buila a tree for
+                                                 //each function then print tree
+    auto it = funcVec[fi];
+    {
   //    cout << "getting Local Multiplier for function "<<(*it).second->name<<endl;
-      local_multiplier =  (*it).second->getMultiplier(period, is_load);
-      map <enum Metrics, double> diagMap;
-      (*it).second->getFPDiag(&diagMap);
-
-      (*it).second->calcCPUFP();
+      map <enum Metrics, double> &diagMap = funcDiagMap[fi];
       int ncpus = (*it).second->ncpus;
-      map <enum Metrics, double> cpuDiagMap[ncpus];
-      for (int i=0; i<ncpus; i++)
-        (*it).second->getCPUFPDiag(&(cpuDiagMap[i]), i);
+      vector <map <enum Metrics, double>> &cpuDiagMap = funcCPUDiagMap[fi];
 
 
   //    cout << "General Multipliler = "<<multiplier<<endl;
@@ -1243,33 +1861,43 @@ int main(int argc, char* argv[], const char* envp[]) {
 //      cout << " Local multiplier = "<<local_multiplier<<endl;
      //local_multiplier = multiplier_ld_from_totals;
      local_multiplier = multiplier2;
-      cout << (*it).second->name << " tot StartIP: "<<hex<<(*it).second->startIP<<" EndIP: "<< (*it).second->endIP<<dec <<" Size: "<< it->second->trace->getSize() << " FP: "<<(*it).second->fp*local_multiplier << " lds: "<<(*it).second->trace->getSize()*imp_to_all_ratio*local_multiplier<<" collected/total: "<<imp_to_all_ratio;
-      cout<<" Strided: "<<diagMap[STRIDED]*local_multiplier <<" Indirect: "<<diagMap[INDIRECT]*local_multiplier<<" Constant: "<<diagMap[CONSTANT]*local_multiplier <<" Unknown: "<<diagMap[UNKNOWN]*local_multiplier;
-      cout << " Multiplier = "<<local_multiplier<<" Growth Rate: "<<((*it).second->fp*local_multiplier)/((*it).second->trace->getSize()*imp_to_all_ratio*local_multiplier)<<endl;
-    
-    cout << "_____________________________________________________________" << endl;
-    cout << "Function Name: " << (*it).second->name << endl; 
-    cout << "tot StartIP: "<<hex<<(*it).second->startIP<< endl
-         << "EndIP: "<< (*it).second->endIP<<dec << endl
-         << "Timevec Size: "<< it->second->trace->getSize() << endl
-         << "Percore Stats:" << endl
-         << "\tCPUID, FP Size, FP, lds, collected/total, Strided, Indirect, Constant, Unknown, Multiplier, Growth Rate" << endl;
+      double lds = (*it).second->getLoads()*imp_to_all_ratio*local_multiplier;
+      funcTable.row().put((*it).second->name).put((*it).second->startIP).put((*it).second->endIP)
+               .put((*it).second->getLoads()).put((*it).second->fp)
+               .put((double)((*it).second->fp*local_multiplier)).put(lds).put(imp_to_all_ratio)
+               .put(diagMap[STRIDED]*local_multiplier).put(diagMap[INDIRECT]*local_multiplier)
+               .put(diagMap[CONSTANT]*local_multiplier).put(diagMap[UNKNOWN]*local_multiplier)
+               .put((double)local_multiplier).put(((*it).second->fp*local_multiplier)/lds)
+               .put((*it).second->sharedFP);
+    if (!is_detailed){
+      continue;
+    }
     for (int cpuid=0; cpuid<ncpus; cpuid++) {
-        cout << "\t"<< cpuid  <<", " << (*it).second->cpuFP[cpuid] << ", "<<(*it).second->cpuFP[cpuid]*local_multiplier << ", "<<(*it).second->trace->getSize()*imp_to_all_ratio*local_multiplier<<", "<<imp_to_all_ratio<<", "<<cpuDiagMap[cpuid][STRIDED]*local_multiplier <<", "<<cpuDiagMap[cpuid][INDIRECT]*local_multiplier<<", "<<cpuDiagMap[cpuid][CONSTANT]*local_multiplier <<", "<<cpuDiagMap[cpuid][UNKNOWN]*local_multiplier;
-      cout << ", "<<local_multiplier<<", "<<((*it).second->cpuFP[cpuid]*local_multiplier)/((*it).second->trace->getSize()*imp_to_all_ratio*local_multiplier)<<endl;
+      funcCPUTable.row().put((*it).second->name).put(store->cpuList[cpuid]).put((*it).second->cpuFP[cpuid])
+                  .put((double)((*it).second->cpuFP[cpuid]*local_multiplier)).put(lds).put(imp_to_all_ratio)
+                  .put(cpuDiagMap[cpuid][STRIDED]*local_multiplier).put(cpuDiagMap[cpuid][INDIRECT]*local_multiplier)
+                  .put(cpuDiagMap[cpuid][CONSTANT]*local_multiplier).put(cpuDiagMap[cpuid][UNKNOWN]*local_multiplier)
+                  .put((double)local_multiplier).put(((*it).second->cpuFP[cpuid]*local_multiplier)/lds)
+                  .put((*it).second->cpuSharedFP[cpuid]);
     }
-    cout << "--------------------------------------------------------------" << endl;
     }
   }
+  // stdout text is rendered from the report tables
+  cout << "Function FP:" << endl;
+  funcTable.printText(cout, cellsize);
+  if (is_detailed){
+    cout << endl << "Percore Stats:" << endl;
+    funcCPUTable.printText(cout, cellsize);
+    report.tables.push_back(move(funcCPUTable));
+  }
 
 //PRINT TREE Averages:
-  cout << "FULL TRACE FP: "<<fullT->getFP() * multiplier<<endl;
+  cout << "FULL TRACE FP: "<<rootFP * multiplier<<endl;
 //   cout << "FULL TRACE CPU FP: "<<endl;
 //   for (int cpuid=0; cpuid < fullT->ncpus; cpuid++)
 //     cout << "\tCPU " << cpuid << ": " << fullT->cpuFP[cpuid] * multiplier << endl;
   cout<<endl << "Printing Level Averages"<<endl;
   const char filler = ' ';
-  const int cellsize = 16;
   //multiplier2 = multiplier_ld_mean;
   //multiplier2 = multiplier_ld_median;
   multiplier2 = multiplier_ld_from_totals;
@@ -1278,57 +1906,22 @@ int main(int argc, char* argv[], const char* envp[]) {
   } else if (multiplier2 < 1 ){
     multiplier2 =1;
   } 
-  long int lds = trace->getSize()*total_ld_multiplier;
+  long int lds = trace_loads*total_ld_multiplier;
+  ReportTable &summary = report.addTable("summary");
+  summary.column("Trace", REPORT_STRING).column("Period", REPORT_INT).column("Samples", REPORT_INT)
+         .column("Size", REPORT_INT).column("Total_Loads", REPORT_INT).column("Multiplier", REPORT_DOUBLE)
+         .column("FP", REPORT_DOUBLE);
+  summary.row().put(inputFile).put(period).put(number_of_windows).put(trace_loads)
+         .put(total_loads_in_trace).put(multiplier2).put((double)(rootFP * multiplier));
+  ReportTable &levels = report.addTable("levels");
+  levels = levelAverages("levels", treeFPavgMap2, multiplier2);
   if (do_output){
-    outFile << left <<setw(cellsize) << setfill(filler)<<"LVL"
-            << left <<setw(cellsize) << setfill(filler)<<"Number_of_Nodes"
-            << left <<setw(cellsize) << setfill(filler)<<"Multiplier"
-            << left <<setw(cellsize) << setfill(filler)<<"Window_Size"
-            << left <<setw(cellsize) << setfill(filler)<<"FP"
-            << left <<setw(cellsize) << setfill(filler)<<"Strided_FP"
-            << left <<setw(cellsize) << setfill(filler)<<"Indirect_FP"
-            << left <<setw(cellsize) << setfill(filler)<<"Constant_Loads"
-            << left <<setw(cellsize) << setfill(filler)<<"Unknown"
-            << left <<setw(cellsize) << setfill(filler)<<"Total_Loads"
-            << left <<setw(cellsize) << setfill(filler)<<"Cont2Load_ratio"
-            << left <<setw(cellsize) << setfill(filler)<<"NPF_Rate"
-            << left <<setw(cellsize) << setfill(filler)<<"NPF_Growth_Rate"
-            << left <<setw(cellsize) << setfill(filler)<<"Growth_Rate"
-            << endl;
+    levels.printText(outFile, cellsize);
   }
   for (auto it = treeFPavgMap2.begin(); it != treeFPavgMap2.end(); it ++){
     int treeLVL = it->first;
     int n_nodes = treeFPavgMap2[treeLVL][NUMBER_OF_NODES];
 //    if (treeFPavgMap2[treeLVL][IN_SAMPLE] == 0){
-    if (do_output){
-      outFile << left <<setw(cellsize) << setfill(filler) << treeLVL   
-              << left <<setw(cellsize) << setfill(filler) << n_nodes; 
-//              << left <<setw(cellsize) << setfill(filler) << multiplier2;
-      if (treeFPavgMap2[treeLVL][IN_SAMPLE] == 0){
-        outFile << left <<setw(cellsize) << setfill(filler) << multiplier2
-                << left <<setw(cellsize) << setfill(filler) << (treeFPavgMap2[treeLVL][WINDOW_SIZE] /n_nodes) * multiplier2
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][FP] / n_nodes) * multiplier2 
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][STRIDED] / n_nodes) * multiplier2
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][INDIRECT] / n_nodes) * multiplier2 
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][CONSTANT] / n_nodes) * multiplier2 
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][UNKNOWN] / n_nodes) * multiplier2 
-                << left <<setw(cellsize) << setfill(filler) << ((treeFPavgMap2[treeLVL][WINDOW_SIZE] + treeFPavgMap2[treeLVL][CONSTANT]) /n_nodes) * multiplier2 ;
-      } else {
-        outFile << left <<setw(cellsize) << setfill(filler) << 1
-                << left <<setw(cellsize) << setfill(filler) << (treeFPavgMap2[treeLVL][WINDOW_SIZE] /n_nodes) 
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][FP] / n_nodes) 
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][STRIDED] / n_nodes)
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][INDIRECT] / n_nodes) 
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][CONSTANT] / n_nodes) 
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][UNKNOWN] / n_nodes) 
-                << left <<setw(cellsize) << setfill(filler) << ((treeFPavgMap2[treeLVL][WINDOW_SIZE] + treeFPavgMap2[treeLVL][CONSTANT]) /n_nodes);
-      }  
-      outFile   << left <<setw(cellsize) << setfill(filler) << (( treeFPavgMap2[treeLVL][CONSTANT] / n_nodes) * multiplier2) / (((treeFPavgMap2[treeLVL][WINDOW_SIZE] + treeFPavgMap2[treeLVL][CONSTANT]) /n_nodes) * multiplier2 )
-                << left <<setw(cellsize) << setfill(filler) << ( treeFPavgMap2[treeLVL][INDIRECT] / treeFPavgMap2[treeLVL][FP] )
-                << left <<setw(cellsize) << setfill(filler) << (( treeFPavgMap2[treeLVL][INDIRECT] / n_nodes) * multiplier2) / ((treeFPavgMap2[treeLVL][WINDOW_SIZE] /n_nodes) * multiplier2 )
-                << left <<setw(cellsize) << setfill(filler) << (( treeFPavgMap2[treeLVL][FP] / n_nodes) * multiplier2) / ((treeFPavgMap2[treeLVL][WINDOW_SIZE] /n_nodes) * multiplier2)
-                << endl;
-      }
       //Checking total loads in that window 
       cout << "LVL: " << treeLVL << " Number_of_Nodes: " << n_nodes << " multiplier2: " << multiplier2 
            << " Window_Size: " << (treeFPavgMap2[treeLVL][WINDOW_SIZE] /n_nodes) *multiplier2
@@ -1394,28 +1987,97 @@ int main(int argc, char* argv[], const char* envp[]) {
 //           << " Constant: " << ( treeFPavgMap2[treeLVL][CONSTANT] / n_nodes)  
 //           << " Unknown: " << ( treeFPavgMap2[treeLVL][UNKNOWN] / n_nodes)  << endl;
 //    }
+  }
+
+  if (do_focus_spec){
+    stats.phase("focus-spec");
+    // sets are independent: analyze them on the thread pool, report in spec order
+    vector <map <int, map<enum Metrics, double>>> focusFPavgMap(focusSpec.sets.size());
+    vector <Window *> focusRoot(focusSpec.sets.size());
+    parallelFor(focusSpec.sets.size(), nthreads, [&](size_t i){
+      focusRoot[i] = analyzeFocusSet(focusSpec.sets[i], period, min_window_size + 1, &focusFPavgMap[i], is_load);
+    });
+    // one row per set; the level averages of set i are table focus_<i>
+    ReportTable &focusTable = report.addTable("focus");
+    focusTable.column("Set", REPORT_INT).column("Kind", REPORT_STRING).column("Name", REPORT_STRING)
+              .column("Lo", REPORT_INT, true).column("Hi", REPORT_INT, true)
+              .column("Loads", REPORT_INT).column("FP", REPORT_DOUBLE);
+    for (size_t i = 0; i < focusSpec.sets.size(); i++){
+      FocusSet &set = focusSpec.sets[i];
+      double fp = (focusRoot[i] != NULL) ? focusRoot[i]->getFP() * multiplier2 : 0;
+      string title = (set.kind == FocusSet::REGION) ? "Focus_Region" : "Focus_Function";
+      cout << title << " " << set.name << " Loads: " << set.trace->getSize() << " FP: " << fp << endl;
+      focusTable.row().put(i).put(string((set.kind == FocusSet::REGION) ? "region" : "function"))
+                .put(set.name).put(set.lo).put(set.hi).put(set.trace->getSize()).put(fp);
+      ReportTable *focusLevels = NULL;
+      if (focusRoot[i] != NULL){
+        focusLevels = &report.addTable("focus_" + to_string(i));
+        *focusLevels = levelAverages("focus_" + to_string(i), focusFPavgMap[i], multiplier2);
+      }
+      if (do_output){
+        outFile << endl << title << " " << set.name;
+        if (set.kind == FocusSet::REGION){
+          outFile << " [0x" << hex << set.lo << "-0x" << set.hi << dec << "]";
+        }
+        outFile << " Loads: " << set.trace->getSize() << " FP: " << fp << endl;
+        if (focusLevels != NULL){
+          focusLevels->printText(outFile, cellsize);
+        }
+      }
+      deleteTree(focusRoot[i]);
+    }
+  }
+
+  if (do_reuse_dist){
+    stats.phase("reuse-dist");
+    ReuseAnalysis reuseDist;
+    reuseDist.analyze(trace, &funcIndex, nthreads);
+    cout << "Reuse distance: accesses "<<reuseDist.total[ReuseAnalysis::RD_TRACE].accesses
+         <<" cold "<<reuseDist.total[ReuseAnalysis::RD_TRACE].cold
+         <<" cold in sample "<<reuseDist.total[ReuseAnalysis::RD_SAMPLE].cold<<endl;
+    ReportTable &reuseTable = report.addTable("reuse_distance");
+    reuseTable = reuseDist.table("reuse_distance", &funcIndex);
+    if (do_output){
+      outFile << endl << "Reuse_Distance (bin 0: distance 0, bin k: distance [2^(k-1), 2^k))" << endl;
+      reuseTable.printText(outFile, cellsize);
+    }
+  }
+  if (do_cct){
+    stats.phase("cct");
+    CCTMetrics cctMetrics;
+    cctMetrics.analyze(&cct, sampleCCT, trace);
+    cout << "Calling contexts: "<<cct.size()<<" frames: "<<cct.frames.size()<<" samples with call path: "<<cct.getNumSamples()<<endl;
+    ReportTable &cctTable = report.addTable("calling_context");
+    cctTable = cctMetrics.table("calling_context", &cct);
+    if (do_output){
+      outFile << endl << "Calling_Context (inclusive unless Excl)" << endl;
+      cctTable.printText(outFile, cellsize);
+    }
   }
    
-    cout <<"Total Trace size: "<<trace->getSize()<<" Important trace size: "<<funcTrace->getSize()<<" Multiplier "<< total_ld_multiplier<<endl;
-    cout <<"Total loads: "<<trace->getSize()*total_ld_multiplier<<" Important loads: "<<funcTrace->getSize()*total_ld_multiplier<<endl;
+    cout <<"Total Trace size: "<<trace_loads<<" Important trace size: "<<funcTrace->getSize()<<" Multiplier "<< total_ld_multiplier<<endl;
+    cout <<"Total loads: "<<trace_loads*total_ld_multiplier<<" Important loads: "<<funcTrace->getSize()*total_ld_multiplier<<endl;
 
   cout << "Tree root multiplier: "<<endl;
-  fullT->calcMultiplier();
+  if (fullT != NULL){
+    fullT->calcMultiplier();
+  }
   if(do_focus){
     //PRINT IMPORTANT FUNCTION
-    memgaze::Function *imp_func = new memgaze::Function(functionName ,0,0, 24);
+    stats.phase("focus-function");
+    memgaze::Function *imp_func = new memgaze::Function(store, functionName ,0UL,0UL);
     cout<<endl << "Printing important function: "<<functionName<<endl;
     unsigned long sTime = 0 , eTime=0;
     for (auto  it =funcTrace->trace.begin(); it != funcTrace->trace.end(); it++){
       imp_func->trace->addAccess(*it);
       if (sTime == 0 ){
-        sTime = (*it)->time->time;
+        sTime = store->timeOf(*it);
       }
-      eTime= (*it)->time->time;
+      eTime= store->timeOf(*it);
     }
     map <enum Metrics, double> diagMap;
     imp_func->calcFP();
-    imp_func->calcCPUFP();
+    imp_func->calcCPUFP(nthreads);
     cout << " Start time: "<< sTime <<" End time: "<<eTime<<endl;
 
     local_multiplier =  imp_func->getMultiplier(period, is_load);
@@ -1425,26 +2087,41 @@ int main(int argc, char* argv[], const char* envp[]) {
 
     imp_func->getFPDiag(&diagMap);
 
+    ReportTable &focusTable = report.addTable("focus_function");
+    focusTable.column("Function", REPORT_STRING).column("StartIP", REPORT_INT, true).column("Size", REPORT_INT)
+              .column("FP_Size", REPORT_INT);
+    ReportTable &focusCPUTable = report.addTable("focus_function_cpus");
+    focusCPUTable.column("Function", REPORT_STRING).column("CPU", REPORT_INT).column("FP_Size", REPORT_INT);
+    const char *focusMetrics[] = {"FP", "Lds", "Strided", "Indirect", "Constant", "Unknown", "Multiplier", "Time_s"};
+    for (const char *m : focusMetrics){
+      focusTable.column(m, REPORT_DOUBLE);
+      focusCPUTable.column(m, REPORT_DOUBLE);
+    }
+    focusTable.column("Shared_FP", REPORT_INT);
+    focusCPUTable.column("Shared_FP", REPORT_INT);
+    focusTable.row().put(imp_func->name).put(imp_func->startIP).put(imp_func->trace->getSize()).put(imp_func->fp)
+              .put((double)(imp_func->fp*local_multiplier)).put(imp_func->totalLoads)
+              .put(diagMap[STRIDED]*local_multiplier).put(diagMap[INDIRECT]*local_multiplier)
+              .put(diagMap[CONSTANT]*local_multiplier).put(diagMap[UNKNOWN]*local_multiplier)
+              .put((double)local_multiplier).put((eTime-sTime)/1000000000.0).put(imp_func->sharedFP);
     cout << "MEM FP analysis on focus function:" <<  imp_func->name << endl;
-
-    cout << imp_func->name << " StartIP: "<<hex<<imp_func->startIP<<dec <<" Size: "<<imp_func->trace->getSize() << " FP: "<<imp_func->fp*local_multiplier << " lds: "<<imp_func->totalLoads ;
-
-    cout<<" Strided: "<<diagMap[STRIDED]*local_multiplier <<" Indirect: "<<diagMap[INDIRECT]*local_multiplier<<" Constant: "<<diagMap[CONSTANT]*local_multiplier <<" Unknown: "<<diagMap[UNKNOWN]*local_multiplier;
-    cout << " Local multiplier = "<<local_multiplier<<" time(s):"<<(eTime-sTime)/1000000000.0<<endl;
+    focusTable.printText(cout, cellsize);
 
     int ncpus = imp_func->ncpus;
     // vector<map <int, double>> cpuDiagMap;
     // cpuDiagMap.reserve(ncpus);
-    cout << endl << "_________________________________________________________________" << endl;
-    cout << "[New] CPU+MEM FP analysis on focus function:" <<  imp_func->name << endl;
-    cout <<"CPUID, StartIP, Size, FP, lds, Strided, Indirect, Constant, Unknown, Local multiplier,time(s)"<<endl;
     for (int cpuid=0; cpuid<ncpus; cpuid++) {
         map <enum Metrics, double> cpuDiagMap;
         imp_func->getCPUFPDiag(&cpuDiagMap, cpuid);
-
-        cout << cpuid << ", " <<hex<<imp_func->startIP<<dec <<", "<<imp_func->cpuFP[cpuid] << ", "<<imp_func->cpuFP[cpuid]*local_multiplier << ", "<<imp_func->totalLoads << "," <<cpuDiagMap[STRIDED]*local_multiplier <<", "<<cpuDiagMap[INDIRECT]*local_multiplier<<", "<<cpuDiagMap[CONSTANT]*local_multiplier <<", "<<cpuDiagMap[UNKNOWN]*local_multiplier;
-        cout << ", "<<local_multiplier<<", "<<(eTime-sTime)/1000000000.0<<endl;
+        focusCPUTable.row().put(imp_func->name).put(store->cpuList[cpuid]).put(imp_func->cpuFP[cpuid])
+                     .put((double)(imp_func->cpuFP[cpuid]*local_multiplier)).put(imp_func->totalLoads)
+                     .put(cpuDiagMap[STRIDED]*local_multiplier).put(cpuDiagMap[INDIRECT]*local_multiplier)
+                     .put(cpuDiagMap[CONSTANT]*local_multiplier).put(cpuDiagMap[UNKNOWN]*local_multiplier)
+                     .put((double)local_multiplier).put((eTime-sTime)/1000000000.0).put(imp_func->cpuSharedFP[cpuid]);
     }
+    cout << endl << "_________________________________________________________________" << endl;
+    cout << "[New] CPU+MEM FP analysis on focus function:" <<  imp_func->name << endl;
+    focusCPUTable.printText(cout, cellsize);
   }
 // Here We are trying to calculate function total fp by checking each window
 // This is work in porgress not finalized
@@ -1479,9 +2156,23 @@ int main(int argc, char* argv[], const char* envp[]) {
 // #endif
 
 
+  stats.phase("report");
+  if (do_report_csv){
+    report.writeCSV(reportCSVPrefix);
+  }
+  if (do_report_bin){
+    report.writeBinary(reportBinFile);
+  }
+
+  if (do_stats){
+    stats.print(cout, store->getSize(), cellsize);
+  }
+
   //Here we free anyhing we created
   delete trace;
   delete funcTrace;
+  delete streamForest;
+  delete store;
  
   outFile.close();
   inFile.close(); 